@@ -7,5 +7,7 @@
 
 #include "Objects/include/Column.h"
 #include "Objects/include/Concrete.h"
+#include "Objects/include/Expression.h"
+#include "Objects/include/CSVBatchReader.h"
 
 #endif //__DATA_FRAME_CONSOLIDATION_H__
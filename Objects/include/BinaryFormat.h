@@ -0,0 +1,322 @@
+//
+// Created by Nathaniel Rupprecht on 5/22/21.
+//
+
+#ifndef __BINARY_FORMAT_H__
+#define __BINARY_FORMAT_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+#include "DFVector.h"
+#include "IndexMap.h"
+
+namespace dataframe {
+
+    // ========================================
+    //  Binary column format.
+    // ========================================
+
+    //! \brief How the data of a column is laid out in a binary DataFrame file. Values are stored in the native byte
+    //! order. Fixed width types are stored as one raw value per entry, bools as one byte per entry, and strings as
+    //! num_rows + 1 offsets (uint64_t) into the bytes of all the strings, which follow the offsets. None and Empty
+    //! columns have no data. Categorical columns store their dictionary, as the number of strings (uint64_t) followed
+    //! by the strings in the same form as a string column, then one code (uint32_t) per entry. Other types cannot be
+    //! stored.
+    //!
+    //! Write takes the entries at positions [0, num_rows), through the index map if there is one. Read is given an owner
+    //! that keeps the data alive, if there is one, so data that is stored as it is in memory can be used in place.
+    template<typename value_type>
+    struct BinaryFormat {
+        static bool Write(const DFVector<value_type> &data, const IndexMap &index_map,
+                          std::size_t num_rows, std::ostream &out) {
+            return false;
+        }
+
+        static bool Read(const char *begin, std::size_t size, std::size_t num_rows, DFVector<value_type> &data,
+                         const std::shared_ptr<const void> &owner) {
+            return false;
+        }
+    };
+
+    namespace detail {
+        //! \brief The number of entries that are gathered into a buffer before they are written.
+        constexpr std::size_t kBinaryBlock = 1 << 14;
+
+        //! \brief Write fixed width values, gathered through the index map a block at a time.
+        template<typename value_type, typename stored_type>
+        bool WriteFixedWidth(const DFVector<value_type> &data,
+                             const IndexMap &index_map,
+                             std::size_t num_rows, std::ostream &out) {
+            if constexpr (std::is_same<value_type, stored_type>::value) {
+                if (index_map.IsContiguous()) { // The data can be written as is.
+                    out.write(reinterpret_cast<const char *>(data.data() + index_map.First()),
+                              static_cast<std::streamsize>(num_rows * sizeof(stored_type)));
+                    return !out.fail();
+                }
+            }
+            std::vector<stored_type> buffer;
+            buffer.reserve(std::min(num_rows, kBinaryBlock));
+            for (std::size_t first = 0; first < num_rows; first += kBinaryBlock) {
+                buffer.clear();
+                auto last = std::min(num_rows, first + kBinaryBlock);
+                index_map.ForEach(first, last, [&](std::size_t index) {
+                    buffer.push_back(static_cast<stored_type>(data[index]));
+                });
+                out.write(reinterpret_cast<const char *>(buffer.data()),
+                          static_cast<std::streamsize>(buffer.size() * sizeof(stored_type)));
+            }
+            return !out.fail();
+        }
+
+        //! \brief Read fixed width values. The data does not have to be aligned. If the values are stored as they are
+        //! in memory, the data is aligned, and there is an owner that keeps the data alive, the vector adopts the data
+        //! instead of copying it.
+        template<typename value_type, typename stored_type>
+        bool ReadFixedWidth(const char *begin, std::size_t size, std::size_t num_rows, DFVector<value_type> &data,
+                            const std::shared_ptr<const void> &owner) {
+            // Compare by division, since a corrupt num_rows can make num_rows * sizeof(stored_type) overflow.
+            if (size / sizeof(stored_type) != num_rows || size % sizeof(stored_type) != 0) {
+                return false;
+            }
+            if constexpr (std::is_same<value_type, stored_type>::value) {
+                if (owner && reinterpret_cast<std::uintptr_t>(begin) % alignof(value_type) == 0) {
+                    data.Adopt(reinterpret_cast<const value_type *>(begin), num_rows, owner);
+                    return true;
+                }
+                data.resize(num_rows);
+                if (num_rows) {
+                    std::memcpy(data.data(), begin, size);
+                }
+                return true;
+            }
+            data.resize(num_rows);
+            for (std::size_t i = 0; i < num_rows; ++i) {
+                stored_type value;
+                std::memcpy(&value, begin + i * sizeof(stored_type), sizeof(stored_type));
+                data[i] = static_cast<value_type>(value);
+            }
+            return true;
+        }
+
+        template<typename value_type>
+        struct FixedWidthFormat {
+            static bool Write(const DFVector<value_type> &data,
+                              const IndexMap &index_map,
+                              std::size_t num_rows, std::ostream &out) {
+                return WriteFixedWidth<value_type, value_type>(data, index_map, num_rows, out);
+            }
+
+            static bool Read(const char *begin, std::size_t size, std::size_t num_rows, DFVector<value_type> &data,
+                             const std::shared_ptr<const void> &owner) {
+                return ReadFixedWidth<value_type, value_type>(begin, size, num_rows, data, owner);
+            }
+        };
+
+        template<typename value_type>
+        struct PlaceholderFormat {
+            static bool Write(const DFVector<value_type> &, const IndexMap &,
+                              std::size_t, std::ostream &) {
+                return true;
+            }
+
+            static bool Read(const char *, std::size_t size, std::size_t num_rows, DFVector<value_type> &data,
+                             const std::shared_ptr<const void> &) {
+                data.resize(num_rows);
+                return size == 0;
+            }
+        };
+    }
+
+    template<>
+    struct BinaryFormat<int> : public detail::FixedWidthFormat<int> {};
+
+    template<>
+    struct BinaryFormat<float> : public detail::FixedWidthFormat<float> {};
+
+    template<>
+    struct BinaryFormat<double> : public detail::FixedWidthFormat<double> {};
+
+    template<>
+    struct BinaryFormat<std::int8_t> : public detail::FixedWidthFormat<std::int8_t> {};
+
+    template<>
+    struct BinaryFormat<std::int16_t> : public detail::FixedWidthFormat<std::int16_t> {};
+
+    template<>
+    struct BinaryFormat<std::int64_t> : public detail::FixedWidthFormat<std::int64_t> {};
+
+    template<>
+    struct BinaryFormat<std::uint8_t> : public detail::FixedWidthFormat<std::uint8_t> {};
+
+    template<>
+    struct BinaryFormat<std::uint16_t> : public detail::FixedWidthFormat<std::uint16_t> {};
+
+    template<>
+    struct BinaryFormat<std::uint32_t> : public detail::FixedWidthFormat<std::uint32_t> {};
+
+    template<>
+    struct BinaryFormat<std::uint64_t> : public detail::FixedWidthFormat<std::uint64_t> {};
+
+    template<>
+    struct BinaryFormat<Timestamp> : public detail::FixedWidthFormat<Timestamp> {};
+
+    template<>
+    struct BinaryFormat<NoneDType> : public detail::PlaceholderFormat<NoneDType> {};
+
+    template<>
+    struct BinaryFormat<EmptyDType> : public detail::PlaceholderFormat<EmptyDType> {};
+
+    template<>
+    struct BinaryFormat<bool> {
+        static bool Write(const DFVector<bool> &data, const IndexMap &index_map,
+                          std::size_t num_rows, std::ostream &out) {
+            return detail::WriteFixedWidth<bool, std::uint8_t>(data, index_map, num_rows, out);
+        }
+
+        static bool Read(const char *begin, std::size_t size, std::size_t num_rows, DFVector<bool> &data,
+                         const std::shared_ptr<const void> &owner) {
+            return detail::ReadFixedWidth<bool, std::uint8_t>(begin, size, num_rows, data, owner);
+        }
+    };
+
+    template<>
+    struct BinaryFormat<std::string> {
+        static bool Write(const DFVector<std::string> &data,
+                          const IndexMap &index_map,
+                          std::size_t num_rows, std::ostream &out) {
+            // The offsets of the strings, then the strings.
+            const std::uint64_t zero = 0;
+            out.write(reinterpret_cast<const char *>(&zero), sizeof(zero));
+            if (index_map.IsFull()) {
+                // The offsets and bytes can be written straight out of the vector.
+                auto num_bytes = num_rows ? data.Ends()[num_rows - 1] : 0;
+                out.write(reinterpret_cast<const char *>(data.Ends().data()),
+                          static_cast<std::streamsize>(num_rows * sizeof(std::uint64_t)));
+                out.write(data.Bytes().data(), static_cast<std::streamsize>(num_bytes));
+                return !out.fail();
+            }
+            std::vector<std::uint64_t> offsets;
+            offsets.reserve(num_rows);
+            std::uint64_t offset = 0;
+            index_map.ForEach(num_rows, [&](std::size_t index) {
+                offset += data[index].size();
+                offsets.push_back(offset);
+            });
+            out.write(reinterpret_cast<const char *>(offsets.data()),
+                      static_cast<std::streamsize>(offsets.size() * sizeof(std::uint64_t)));
+            std::string buffer;
+            std::size_t i = 0;
+            index_map.ForEach(num_rows, [&](std::size_t index) {
+                buffer += data[index];
+                if (buffer.size() >= detail::kBinaryBlock * 16 || ++i == num_rows) {
+                    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                    buffer.clear();
+                }
+            });
+            return !out.fail();
+        }
+
+        static bool Read(const char *begin, std::size_t size, std::size_t num_rows, DFVector<std::string> &data,
+                         const std::shared_ptr<const void> &owner) {
+            if (size / sizeof(std::uint64_t) <= num_rows) {
+                return false;
+            }
+            auto offsets_size = (num_rows + 1) * sizeof(std::uint64_t);
+            auto strings = begin + offsets_size;
+            auto strings_size = size - offsets_size;
+            data.resize(0);
+            data.Reserve(num_rows);
+            data.ReserveBytes(strings_size);
+            std::uint64_t first, last;
+            std::memcpy(&first, begin, sizeof(std::uint64_t));
+            for (std::size_t i = 0; i < num_rows; ++i) {
+                std::memcpy(&last, begin + (i + 1) * sizeof(std::uint64_t), sizeof(std::uint64_t));
+                if (last < first || strings_size < last) {
+                    return false;
+                }
+                data.push_back(std::string_view(strings + first, last - first));
+                first = last;
+            }
+            return true;
+        }
+    };
+
+    template<>
+    struct BinaryFormat<Categorical> {
+        static bool Write(const DFVector<Categorical> &data,
+                          const IndexMap &index_map,
+                          std::size_t num_rows, std::ostream &out) {
+            // The dictionary, then the codes.
+            const auto &dictionary = data.Dictionary();
+            std::vector<std::uint64_t> offsets{0};
+            offsets.reserve(dictionary.size() + 1);
+            for (std::uint32_t code = 0; code < dictionary.size(); ++code) {
+                offsets.push_back(offsets.back() + dictionary[code].size());
+            }
+            auto num_categories = static_cast<std::uint64_t>(dictionary.size());
+            out.write(reinterpret_cast<const char *>(&num_categories), sizeof(num_categories));
+            out.write(reinterpret_cast<const char *>(offsets.data()),
+                      static_cast<std::streamsize>(offsets.size() * sizeof(std::uint64_t)));
+            for (std::uint32_t code = 0; code < dictionary.size(); ++code) {
+                out.write(dictionary[code].data(), static_cast<std::streamsize>(dictionary[code].size()));
+            }
+            return detail::WriteFixedWidth<std::uint32_t, std::uint32_t>(data.Codes(), index_map, num_rows, out);
+        }
+
+        static bool Read(const char *begin, std::size_t size, std::size_t num_rows, DFVector<Categorical> &data,
+                         const std::shared_ptr<const void> &owner) {
+            std::uint64_t num_categories;
+            if (size < sizeof(num_categories)) {
+                return false;
+            }
+            std::memcpy(&num_categories, begin, sizeof(num_categories));
+            auto offsets = begin + sizeof(num_categories);
+            if ((size - sizeof(num_categories)) / sizeof(std::uint64_t) <= num_categories) {
+                return false;
+            }
+            auto strings = offsets + (num_categories + 1) * sizeof(std::uint64_t);
+            auto remaining = static_cast<std::size_t>(begin + size - strings);
+
+            // Add the strings to the dictionary, recording the code each one gets.
+            data.resize(0);
+            std::vector<std::uint32_t> translation;
+            translation.reserve(num_categories);
+            std::uint64_t first, last;
+            std::memcpy(&first, offsets, sizeof(std::uint64_t));
+            for (std::uint64_t i = 0; i < num_categories; ++i) {
+                std::memcpy(&last, offsets + (i + 1) * sizeof(std::uint64_t), sizeof(std::uint64_t));
+                if (last < first || remaining < last) {
+                    return false;
+                }
+                translation.push_back(data.AddCategory(std::string_view(strings + first, last - first)));
+                first = last;
+            }
+
+            auto codes = strings + first;
+            auto codes_size = static_cast<std::size_t>(begin + size - codes);
+            if (codes_size / sizeof(std::uint32_t) != num_rows || codes_size % sizeof(std::uint32_t) != 0) {
+                return false;
+            }
+            data.Reserve(num_rows);
+            for (std::size_t i = 0; i < num_rows; ++i) {
+                std::uint32_t code;
+                std::memcpy(&code, codes + i * sizeof(std::uint32_t), sizeof(std::uint32_t));
+                if (num_categories <= code) {
+                    return false;
+                }
+                data.PushCode(translation[code]);
+            }
+            return true;
+        }
+    };
+
+}
+#endif // __BINARY_FORMAT_H__
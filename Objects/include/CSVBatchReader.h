@@ -0,0 +1,123 @@
+//
+// Created by Nathaniel Rupprecht on 5/18/21.
+//
+
+#ifndef __CSV_BATCH_READER_H__
+#define __CSV_BATCH_READER_H__
+
+#include <fstream>
+#include <memory>
+
+#include "DataFrame.h"
+#include "Column.h"
+#include "CSVTokenizer.h"
+
+namespace dataframe {
+
+    //! \brief Reads a csv as a sequence of DataFrames with a fixed number of rows each, so csvs that are larger than
+    //! memory can be processed with bounded memory.
+    //!
+    //! The dtypes of the columns are decided by the first batch (or given by the options), and every later batch starts
+    //! out with the same dtypes. If a later batch has a field that does not fit its column's dtype, the column is
+    //! widened, the same way as when a whole csv is read, and the widened dtype is used for the rest of the batches.
+    //! WidenedColumns reports which columns the last batch widened. Only the data for the current batch is held in
+    //! memory. If the options ask to sample dtypes, the rows of the first batch are sampled.
+    //! \code
+    //! CSVBatchReader reader("filename.csv", 100000);
+    //! DataFrame batch;
+    //! while (reader.Next(batch)) {
+    //!     // ...
+    //! }
+    //! \endcode
+    class CSVBatchReader {
+    public:
+        // ========================================
+        //  Constructors.
+        // ========================================
+
+        //! \brief Read batches of batch_size rows from a stream. The stream must outlive the reader.
+        CSVBatchReader(std::istream &in, std::size_t batch_size, const CSVOptions &options = CSVOptions());
+
+        //! \brief Read batches of batch_size rows from a csv file.
+        CSVBatchReader(const std::string &filename, std::size_t batch_size, const CSVOptions &options = CSVOptions());
+
+        // ========================================
+        //  Reading.
+        // ========================================
+
+        //! \brief Read the next batch of (at most batch_size) rows into batch. If batch holds a previous batch and
+        //! nothing else references its columns, the columns' memory is reused. Returns false, and leaves batch empty,
+        //! once all rows have been read.
+        bool Next(DataFrame &batch);
+
+        // ========================================
+        //  Accessors.
+        // ========================================
+
+        //! \brief Whether the csv could be opened.
+        bool IsOpen() const { return in_ != nullptr; }
+
+        //! \brief The names and dtypes of the columns of the batches. Columns that have only had empty fields so far
+        //! have DType::None, and will get the dtype of the first batch in which they have data.
+        Schema GetSchema() const;
+
+        //! \brief The names of the columns whose dtypes the last batch widened, because it had fields that did not fit
+        //! the dtypes of the earlier batches. The earlier batches are not changed.
+        const std::vector<std::string> &WidenedColumns() const { return widened_; }
+
+    private:
+        // ========================================
+        //  Private helper functions.
+        // ========================================
+
+        //! \brief Read the header of the csv and plan how rows are read.
+        void ReadHeader();
+
+        //! \brief Read from the stream until the buffer holds batch_size complete rows or the stream ends. Returns the
+        //! number of bytes at the front of the buffer that make up the batch.
+        std::size_t FillBuffer();
+
+        // ========================================
+        //  Private member data.
+        // ========================================
+
+        //! \brief The file, if the reader opened the csv itself.
+        std::unique_ptr<std::ifstream> file_;
+
+        //! \brief The stream the csv is read from, or null if the csv could not be opened.
+        std::istream *in_ = nullptr;
+
+        //! \brief The number of rows in each batch.
+        std::size_t batch_size_;
+
+        //! \brief The options for reading the csv.
+        CSVOptions options_;
+
+        //! \brief Finds the ends of rows, and reads the header.
+        CSVTokenizer tokenizer_;
+
+        //! \brief How the fields of each row are read.
+        DataFrame::ParsePlan plan_;
+
+        //! \brief The names of the columns of the batches.
+        std::vector<std::string> names_;
+
+        //! \brief The dtypes of the columns of the batches.
+        std::vector<DType> dtypes_;
+
+        //! \brief The columns whose dtypes the last batch widened.
+        std::vector<std::string> widened_;
+
+        //! \brief Whether the first batch has been read.
+        bool started_ = false;
+
+        //! \brief Data that has been read from the stream, but not yet parsed. Only the bytes for the current batch
+        //! (plus at most one block) are held at any time.
+        std::string buffer_;
+
+        //! \brief The number of bytes that are read from the stream at a time.
+        static constexpr std::size_t kBlockSize = 1 << 20;
+    };
+
+}
+#endif // __CSV_BATCH_READER_H__
@@ -0,0 +1,112 @@
+//
+// Created by Nathaniel Rupprecht on 5/15/21.
+//
+
+#ifndef __CSV_OPTIONS_H__
+#define __CSV_OPTIONS_H__
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <string_view>
+
+#include "DTypes.h"
+
+namespace dataframe {
+
+    //! \brief The names and dtypes of the columns of a DataFrame, in order.
+    using Schema = std::vector<std::pair<std::string, DType>>;
+
+    //! \brief A filter on the rows of a csv, applied while the csv is read. A row is only kept if keep returns true
+    //! for the row's (whitespace trimmed) field in the column. The filter is checked before any of the row's other
+    //! fields are parsed or stored.
+    struct RowFilter {
+        //! \brief The name of the column whose field is tested.
+        std::string column;
+
+        //! \brief Returns whether a row with this field should be kept. Called concurrently when the csv is parsed on
+        //! several threads.
+        std::function<bool(std::string_view)> keep;
+    };
+
+    //! \brief Options that control how a csv is read into a DataFrame, or written from one. The default options read
+    //! the csv serially, line by line, exactly like DataFrame::FromStream(std::istream&). When writing, only the
+    //! delimiter, quote, num_threads, and write_block_rows are used.
+    struct CSVOptions {
+        //! \brief The character that separates the fields of a row.
+        char delimiter = ',';
+
+        //! \brief The character that quotes fields, so they can contain delimiters, newlines, and (doubled) quotes.
+        //! If this is '\0', fields are never quoted.
+        char quote = '"';
+
+        //! \brief The number of threads used to parse the body of the csv, or to format it when writing. If this is
+        //! zero, the hardware concurrency is used. With a single thread, the csv is read serially.
+        std::size_t num_threads = 1;
+
+        //! \brief The minimum number of bytes that each thread will be given to parse. Splitting small inputs into
+        //! many chunks costs more than it saves.
+        std::size_t min_chunk_size = 1 << 20;
+
+        //! \brief If true, ReadCSV memory maps the file and parses fields in place, instead of reading the file
+        //! through a stream. Bytes are only copied when a value is stored in its column.
+        bool memory_map = false;
+
+        //! \brief If true, the dtypes of the columns are decided before parsing, by sampling rows from the head of the
+        //! csv and short runs of rows spaced evenly through it. This avoids converting columns to new dtypes (and
+        //! copying them) in the middle of reading. If a later row does not fit the sampled dtype, the column is still
+        //! converted, just like when no sampling is done.
+        bool sample_dtypes = false;
+
+        //! \brief The number of rows at the head of the csv that are sampled.
+        std::size_t sample_head_rows = 1000;
+
+        //! \brief The number of evenly spaced places, after the head, where rows are sampled.
+        std::size_t sample_strides = 64;
+
+        //! \brief The number of rows that are sampled at each of the evenly spaced places.
+        std::size_t sample_stride_rows = 16;
+
+        //! \brief Known dtypes of columns, by column name. These columns are created with their dtypes and parsed
+        //! directly into them, without any inference. Fields that cannot be parsed as the dtype are stored as nulls.
+        //! Columns that are not listed are inferred as usual.
+        std::map<std::string, DType> dtypes;
+
+        //! \brief Formats of timestamp columns, by column name, in the style of strptime (see TimestampFormat), e.g.
+        //! "%m/%d/%Y %H:%M". These columns are parsed directly into DType::Timestamp with their formats, which are
+        //! compiled once, before any rows are read. Fields that do not match the format are stored as nulls. Columns
+        //! without formats are still inferred as timestamps if they are in one of the formats InferTimestamp accepts.
+        std::map<std::string, std::string> timestamp_formats;
+
+        //! \brief The full, ordered schema of the csv. If not empty, it must have one entry per column of the csv.
+        //! Its names replace the names in the csv's header, and columns are parsed directly into its dtypes, like
+        //! columns in dtypes are. Entries with DType::None are inferred as usual.
+        Schema schema;
+
+        //! \brief If not empty, only these columns are read. Columns keep the order they have in the csv. Fields of
+        //! other columns are skipped without being parsed. Reading throws if one of them is not in the csv.
+        std::vector<std::string> use_columns;
+
+        //! \brief Filters on the rows of the csv. Only rows that pass every filter are stored. The filtered columns do
+        //! not have to be read.
+        std::vector<RowFilter> row_filters;
+
+        //! \brief Inferred string columns with at most this many distinct values per row are made categorical
+        //! (DType::Categorical) once the csv has been read. Columns given dtypes by the options are never changed. If
+        //! this is zero, columns are never made categorical.
+        double categorical_fraction = 0.05;
+
+        //! \brief If true, inferred integer columns are converted to the narrowest integer dtypes (Int8 through Int64,
+        //! and UInt8 through UInt32) that hold all of their values, once the csv has been read. Columns given dtypes by
+        //! the options are never changed. CSVBatchReader does not narrow columns, since later batches may not fit.
+        bool narrow_integers = false;
+
+        //! \brief When writing a csv, the number of rows that are formatted into a buffer before it is written. With
+        //! more than one thread, each thread formats its own block of rows.
+        std::size_t write_block_rows = 1 << 14;
+    };
+
+}
+#endif // __CSV_OPTIONS_H__
@@ -0,0 +1,285 @@
+//
+// Created by Nathaniel Rupprecht on 5/20/21.
+//
+
+#ifndef __CSV_TOKENIZER_H__
+#define __CSV_TOKENIZER_H__
+
+#include <cstring>
+#include <deque>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CompareKernels.h"
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace dataframe {
+
+    // ========================================
+    //  Scanning for structural characters.
+    // ========================================
+
+    namespace detail {
+
+        //! \brief Find the first occurrence of either of two characters in [begin, end), or end if neither occurs.
+        //! Blocks of 16 bytes are compared at once with SSE2, and the position of the first match is found from the
+        //! block's match bitmask.
+        inline const char *FindEitherSse2(const char *begin, const char *end, char a, char b) {
+#if defined(__SSE2__)
+            const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b);
+            for (; begin + 16 <= end; begin += 16) {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+                auto mask = static_cast<unsigned>(_mm_movemask_epi8(
+                        _mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb))));
+                if (mask) {
+                    return begin + __builtin_ctz(mask);
+                }
+            }
+#endif
+            for (; begin < end; ++begin) {
+                if (*begin == a || *begin == b) {
+                    return begin;
+                }
+            }
+            return end;
+        }
+
+#if defined(__x86_64__)
+        //! \brief FindEither for processors with AVX2, which compares blocks of 32 bytes. It is compiled for AVX2
+        //! whether or not the rest of the library is, so it must only be called if the processor has AVX2.
+        __attribute__((target("avx2")))
+        inline const char *FindEitherAvx2(const char *begin, const char *end, char a, char b) {
+            const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b);
+            for (; begin + 32 <= end; begin += 32) {
+                auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+                auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(block, va), _mm256_cmpeq_epi8(block, vb))));
+                if (mask) {
+                    return begin + __builtin_ctz(mask);
+                }
+            }
+            return FindEitherSse2(begin, end, a, b);
+        }
+#endif
+
+        //! \brief Find the first occurrence of either of two characters in [begin, end), or end if neither occurs.
+        //! If use_avx2 is true, which it may only be if the processor has AVX2 (see kernels::GetSimdLevel), blocks of
+        //! 32 bytes are compared at once instead of 16.
+        inline const char *FindEither(const char *begin, const char *end, char a, char b, bool use_avx2) {
+#if defined(__x86_64__)
+            if (use_avx2) {
+                return FindEitherAvx2(begin, end, a, b);
+            }
+#endif
+            return FindEitherSse2(begin, end, a, b);
+        }
+
+        //! \brief Find the first occurrence of a character in [begin, end), or end if it does not occur.
+        inline const char *Find(const char *begin, const char *end, char c) {
+            auto ptr = static_cast<const char *>(std::memchr(begin, c, end - begin));
+            return ptr ? ptr : end;
+        }
+
+        //! \brief Count the occurrences of a character in [begin, end), using the popcount of block match bitmasks.
+        inline std::size_t Count(const char *begin, const char *end, char c) {
+            std::size_t count = 0;
+#if defined(__SSE2__)
+            const __m128i vc = _mm_set1_epi8(c);
+            for (; begin + 16 <= end; begin += 16) {
+                auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+                count += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, vc))));
+            }
+#endif
+            for (; begin < end; ++begin) {
+                count += *begin == c;
+            }
+            return count;
+        }
+
+    }
+
+    // ========================================
+    //  CSVTokenizer.
+    // ========================================
+
+    //! \brief Splits the rows of a csv into fields, following RFC 4180.
+    //!
+    //! Fields are separated by the delimiter, and rows by newlines (a carriage return before the newline is ignored).
+    //! A field that starts with the quote character is quoted: it may contain delimiters, newlines, and quotes, which
+    //! are escaped by doubling them, and it ends at the next single quote character. Whitespace around unquoted
+    //! fields and outside of the quotes of quoted fields is trimmed. Rows that are blank have no fields.
+    //!
+    //! Fields are views into the csv. Only quoted fields that contain escaped quotes are copied (into the
+    //! tokenizer), so a field is valid until the next row is tokenized.
+    class CSVTokenizer {
+    public:
+        //! \brief Create a tokenizer. A quote character of '\0' turns off quoting.
+        explicit CSVTokenizer(char delimiter = ',', char quote = '"')
+                : delimiter_(delimiter), quote_(quote),
+                  use_avx2_(kernels::GetSimdLevel() == kernels::SimdLevel::AVX2) {}
+
+        //! \brief Split the row that starts at begin into fields, calling f(index, field) for the first max_fields
+        //! fields. Returns the beginning of the next row.
+        template<typename Function>
+        const char *ForEachField(const char *begin, const char *end, std::size_t max_fields, Function &&f) {
+            // Blank rows have no fields.
+            auto ptr = begin;
+            for (; ptr < end && *ptr != '\n' && IsBlank(*ptr); ++ptr);
+            if (ptr == end || *ptr == '\n') {
+                return ptr == end ? end : ptr + 1;
+            }
+
+            for (std::size_t index = 0;; ++index) {
+                if (index == max_fields) {
+                    // Skip the rest of the row.
+                    auto row_end = FindRowEnd(ptr, end);
+                    return row_end == end ? end : row_end + 1;
+                }
+
+                for (; ptr < end && IsBlank(*ptr); ++ptr);
+                if (ptr < end && quote_ != '\0' && *ptr == quote_) {
+                    ptr = QuotedField(ptr + 1, end, index, f);
+                }
+                else {
+                    auto field_end = detail::FindEither(ptr, end, delimiter_, '\n', use_avx2_);
+                    auto last = field_end;
+                    for (; ptr < last && IsSpace(last[-1]); --last);
+                    f(index, std::string_view(ptr, last - ptr));
+                    ptr = field_end;
+                }
+
+                if (ptr == end) {
+                    return end;
+                }
+                if (*ptr == '\n') {
+                    return ptr + 1;
+                }
+                // A delimiter. Even if this is the end of the row, there is another (empty) field after it.
+                ++ptr;
+            }
+        }
+
+        //! \brief Find the newline that ends the row that starts at begin, or end if the row is the last one and has
+        //! no newline.
+        const char *FindRowEnd(const char *begin, const char *end) const {
+            return FindUnquotedNewline(begin, end, false);
+        }
+
+        //! \brief Find the beginning of the first row that starts after target. The row_start must be the beginning
+        //! of a row at or before target, so it is known whether target is inside a quoted field.
+        const char *FindRowStart(const char *row_start, const char *target, const char *end) const {
+            bool in_quotes = quote_ != '\0' && detail::Count(row_start, target, quote_) % 2 == 1;
+            auto newline = FindUnquotedNewline(target, end, in_quotes);
+            return newline == end ? end : newline + 1;
+        }
+
+        //! \brief Read a row from a stream, including any newlines inside of quoted fields. The row does not include
+        //! the newline that ends it. Returns false if there were no more rows.
+        bool ReadRow(std::istream &in, std::string &row) const {
+            if (!getline(in, row)) {
+                return false;
+            }
+            if (quote_ != '\0') {
+                std::string line;
+                // An odd number of quotes means that the row ends in the middle of a quoted field.
+                auto num_quotes = detail::Count(row.data(), row.data() + row.size(), quote_);
+                while (num_quotes % 2 == 1 && getline(in, line)) {
+                    row += '\n';
+                    row += line;
+                    num_quotes += detail::Count(line.data(), line.data() + line.size(), quote_);
+                }
+            }
+            return true;
+        }
+
+    private:
+        //! \brief Whether a character is whitespace that is trimmed from the beginning of a field.
+        bool IsBlank(char c) const {
+            return c != delimiter_ && (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f');
+        }
+
+        //! \brief Whether a character is whitespace that is trimmed from the end of an unquoted field. The delimiter
+        //! and newline can never be at the end of a field.
+        static bool IsSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        //! \brief Read a quoted field whose contents start at begin, call f(index, field) with the unescaped
+        //! contents, and return the position of the delimiter or newline after the field (or end).
+        template<typename Function>
+        const char *QuotedField(const char *begin, const char *end, std::size_t index, Function &&f) {
+            auto ptr = begin;
+            bool escaped = false;
+            while (true) {
+                ptr = detail::Find(ptr, end, quote_);
+                if (ptr + 1 < end && ptr[1] == quote_) { // An escaped quote.
+                    escaped = true;
+                    ptr += 2;
+                    continue;
+                }
+                break;
+            }
+            std::string_view contents(begin, ptr - begin);
+            if (escaped) {
+                if (unescaped_.size() <= index) {
+                    unescaped_.resize(index + 1);
+                }
+                auto &buffer = unescaped_[index];
+                buffer.clear();
+                for (std::size_t i = 0; i < contents.size(); ++i) {
+                    buffer.push_back(contents[i]);
+                    i += contents[i] == quote_; // Skip the second quote of the pair.
+                }
+                contents = buffer;
+            }
+            f(index, contents);
+            // Skip the closing quote, and anything between it and the end of the field.
+            return ptr == end ? end : detail::FindEither(ptr + 1, end, delimiter_, '\n', use_avx2_);
+        }
+
+        //! \brief Find the first newline at or after begin that is not in a quoted field.
+        const char *FindUnquotedNewline(const char *begin, const char *end, bool in_quotes) const {
+            if (quote_ == '\0') {
+                return detail::Find(begin, end, '\n');
+            }
+            auto ptr = begin;
+            while (ptr < end) {
+                if (in_quotes) {
+                    ptr = detail::Find(ptr, end, quote_);
+                }
+                else {
+                    ptr = detail::FindEither(ptr, end, quote_, '\n', use_avx2_);
+                    if (ptr < end && *ptr == '\n') {
+                        return ptr;
+                    }
+                }
+                if (ptr < end) { // A quote, which starts or ends a quoted field.
+                    in_quotes = !in_quotes;
+                    ++ptr;
+                }
+            }
+            return end;
+        }
+
+        //! \brief The character that separates fields.
+        char delimiter_;
+
+        //! \brief The character that quotes fields, or '\0' if fields are not quoted.
+        char quote_;
+
+        //! \brief Whether the processor has AVX2, so fields can be scanned for 32 bytes at a time.
+        bool use_avx2_;
+
+        //! \brief Storage for quoted fields that contained escaped quotes, by field index. Reused from row to row. The
+        //! fields of a row may all be kept until the end of the row, so this is a deque, whose strings do not move when
+        //! it grows.
+        std::deque<std::string> unescaped_;
+    };
+
+}
+#endif // __CSV_TOKENIZER_H__
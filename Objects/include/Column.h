@@ -10,16 +10,30 @@
 #include <limits>
 #include <utility>
 #include <set>
+#include <future>
+#include <thread>
 
 #include "DataFrame.h"
 #include "TypeConversion.h"
 #include "Comparison.h"
 
 #include "DFVector.h"
+#include "BinaryFormat.h"
+#include "Validity.h"
+#include "Reductions.h"
 
 
 namespace dataframe {
 
+    // Lazy expressions over columns, see Expression.h.
+    template<typename> struct NumericExpression;
+    template<typename> struct BooleanExpression;
+    template<typename> class ScalarComparison;
+    namespace detail {
+        //! \brief The base of every expression type.
+        struct ExpressionTag {};
+    }
+
     //! \brief A column is like a type-erased vector, though with a number of important differences.
     //!
     //! A column (or a concrete column, i.e. a "Concrete") does not have a push_back or equivalent function.
@@ -32,42 +46,72 @@ namespace dataframe {
         //  Logical operators.
         // ========================================
 
-        friend Indicator operator<(const Column& col, double rhs);
-        friend Indicator operator<(const Column& col, int rhs);
-        friend Indicator operator<(double rhs, const Column& col);
-        friend Indicator operator<(int rhs, const Column& col);
-
-        friend Indicator operator<=(const Column& col, double rhs);
-        friend Indicator operator<=(const Column& col, int rhs);
-        friend Indicator operator<=(double rhs, const Column& col);
-        friend Indicator operator<=(int rhs, const Column& col);
-
-        friend Indicator operator>(const Column& col, double rhs);
-        friend Indicator operator>(const Column& col, int rhs);
-        friend Indicator operator>(double rhs, const Column& col);
-        friend Indicator operator>(int rhs, const Column& col);
-
-        friend Indicator operator>=(const Column& col, double rhs);
-        friend Indicator operator>=(const Column& col, int rhs);
-        friend Indicator operator>=(double rhs, const Column& col);
-        friend Indicator operator>=(int rhs, const Column& col);
-
-        friend Indicator operator==(const Column& col, double rhs);
-        friend Indicator operator==(const Column& col, int rhs);
-        friend Indicator operator==(double rhs, const Column& col);
-        friend Indicator operator==(int rhs, const Column& col);
-        friend Indicator operator==(const std::string& rhs, const Column& col);
-        friend Indicator operator==(const Column& col, const std::string& rhs);
+        // Comparisons with a value are lazy, so that several of them combined with &, |, ^, or ~ are evaluated
+        // together, see ScalarComparison. Comparisons of two columns are evaluated right away.
+        friend ScalarComparison<double> operator<(const Column& col, double rhs);
+        friend ScalarComparison<int> operator<(const Column& col, int rhs);
+        friend ScalarComparison<double> operator<(double rhs, const Column& col);
+        friend ScalarComparison<int> operator<(int rhs, const Column& col);
+
+        friend ScalarComparison<double> operator<=(const Column& col, double rhs);
+        friend ScalarComparison<int> operator<=(const Column& col, int rhs);
+        friend ScalarComparison<double> operator<=(double rhs, const Column& col);
+        friend ScalarComparison<int> operator<=(int rhs, const Column& col);
+
+        friend ScalarComparison<double> operator>(const Column& col, double rhs);
+        friend ScalarComparison<int> operator>(const Column& col, int rhs);
+        friend ScalarComparison<double> operator>(double rhs, const Column& col);
+        friend ScalarComparison<int> operator>(int rhs, const Column& col);
+
+        friend ScalarComparison<double> operator>=(const Column& col, double rhs);
+        friend ScalarComparison<int> operator>=(const Column& col, int rhs);
+        friend ScalarComparison<double> operator>=(double rhs, const Column& col);
+        friend ScalarComparison<int> operator>=(int rhs, const Column& col);
+
+        friend ScalarComparison<double> operator==(const Column& col, double rhs);
+        friend ScalarComparison<int> operator==(const Column& col, int rhs);
+        friend ScalarComparison<double> operator==(double rhs, const Column& col);
+        friend ScalarComparison<int> operator==(int rhs, const Column& col);
+        friend ScalarComparison<std::string> operator==(const std::string& rhs, const Column& col);
+        friend ScalarComparison<std::string> operator==(const Column& col, const std::string& rhs);
+
+        friend ScalarComparison<double> operator!=(const Column& col, double rhs);
+        friend ScalarComparison<int> operator!=(const Column& col, int rhs);
+        friend ScalarComparison<double> operator!=(double rhs, const Column& col);
+        friend ScalarComparison<int> operator!=(int rhs, const Column& col);
+        friend ScalarComparison<std::string> operator!=(const std::string& rhs, const Column& col);
+        friend ScalarComparison<std::string> operator!=(const Column& col, const std::string& rhs);
+
+        friend ScalarComparison<Timestamp> operator<(const Column& col, const Timestamp& rhs);
+        friend ScalarComparison<Timestamp> operator<(const Timestamp& rhs, const Column& col);
+        friend ScalarComparison<Timestamp> operator<=(const Column& col, const Timestamp& rhs);
+        friend ScalarComparison<Timestamp> operator<=(const Timestamp& rhs, const Column& col);
+        friend ScalarComparison<Timestamp> operator>(const Column& col, const Timestamp& rhs);
+        friend ScalarComparison<Timestamp> operator>(const Timestamp& rhs, const Column& col);
+        friend ScalarComparison<Timestamp> operator>=(const Column& col, const Timestamp& rhs);
+        friend ScalarComparison<Timestamp> operator>=(const Timestamp& rhs, const Column& col);
+        friend ScalarComparison<Timestamp> operator==(const Column& col, const Timestamp& rhs);
+        friend ScalarComparison<Timestamp> operator==(const Timestamp& rhs, const Column& col);
+        friend ScalarComparison<Timestamp> operator!=(const Column& col, const Timestamp& rhs);
+        friend ScalarComparison<Timestamp> operator!=(const Timestamp& rhs, const Column& col);
 
         friend Indicator operator<(const Column& colA, const Column& colB);
+        friend Indicator operator<=(const Column& colA, const Column& colB);
         friend Indicator operator>(const Column& colA, const Column& colB);
+        friend Indicator operator>=(const Column& colA, const Column& colB);
+        friend Indicator operator==(const Column& colA, const Column& colB);
+        friend Indicator operator!=(const Column& colA, const Column& colB);
 
-        bool operator==(const Column& rhs);
+        //! \brief Whether two columns hold the same data. Use == to compare two columns entry by entry.
+        bool Equals(const Column& rhs) const;
 
         // ========================================
         //  Assignment.
         // ========================================
 
+        //! \brief A copy of a column refers to the same data as the column.
+        Column(const Column&) = default;
+
         template<typename T>
         Column& operator=(const std::vector<T>& rhs);
 
@@ -76,11 +120,21 @@ namespace dataframe {
 
         Column& operator=(const Column& rhs);
 
+        //! \brief Evaluate an expression for every row, and assign the results to the column as doubles. Rows of the
+        //! expression that are null are null in the column.
+        template<typename E>
+        Column& operator=(const NumericExpression<E>& expression);
+
+        //! \brief Evaluate a predicate for every row, and assign the results to the column as bools.
+        template<typename E>
+        Column& operator=(const BooleanExpression<E>& expression);
+
         // ========================================
         //  Other functions.
         // ========================================
 
-        //! \brief Check if another column is a reference to the same underlying data.
+        //! \brief Check if another column is a reference to the same underlying data. Clones are not references, even
+        //! while they share data with the column they were cloned from.
         bool IsRefOf(const Column& rhs) const;
 
         //! \brief Check if another column has the same underlying type as this column.
@@ -100,10 +154,16 @@ namespace dataframe {
 
         //! \brief Attempt to get a Concrete<T> for the column. If the actual type of the Column is T,
         //! then this operation returns the Concrete<T> for this column. Otherwise, an empty Concrete<T>
-        //! is returned.
+        //! is returned. Concretes access the data directly, so the column is compacted first, and since a concrete can
+        //! write to the column, a column that shares its data with a clone gets its own copy of the data first.
         template<typename T>
         DataFrame::Concrete<T> GetConcrete() const;
 
+        //! \brief Get a Concrete<T> for the column to read from, as GetConcrete does, but without copying data that the
+        //! column shares with a clone. The concrete must not be written to, or copied into a concrete that is.
+        template<typename T>
+        const DataFrame::Concrete<T> ReadConcrete() const;
+
         //! \brief Attempts to return a vector of type T from the column's data. If the type conversion cannot be made,
         //! an empty vector is returned.
         template<typename T>
@@ -133,11 +193,11 @@ namespace dataframe {
         //! \brief Get unique values held in the column, assuming the concrete type is T. Returns an
         //! empty set if the underlying type is not T.
         //!
-        //! This is the same as calling GetConcrete<T>().Unique().
+        //! This is the same as calling ReadConcrete<T>().Unique().
         template<typename T>
         std::set<T> Unique() const;
 
-        //! \brief Create a copy, by value, of this column.
+        //! \brief Create a copy, by value, of this column. The copy shares the column's data until either one is written to.
         Column Clone() const;
 
         // ========================================
@@ -159,6 +219,54 @@ namespace dataframe {
         //! \brief Write the index-th element of the column to an ostream.
         void ToStream(std::size_t index, std::ostream& out) const;
 
+        //! \brief Whether the index-th element of the column is null.
+        bool IsNull(std::size_t index) const;
+
+        //! \brief The number of null elements in the column.
+        std::size_t NullCount() const;
+
+        //! \brief Coalesce the chunks that appending linked onto the column into one contiguous block.
+        void Compact();
+
+        //! \brief The number of separate blocks the column's data is stored in. Appending to a column links on new
+        //! blocks instead of reallocating the data already in it.
+        std::size_t NumChunks() const;
+
+        //! \brief Write elements [first, first + count) of the column into out, as doubles. Null elements, and elements
+        //! that are not numbers, are NaN.
+        void ReadDoubles(std::size_t first, std::size_t count, double* out) const;
+
+        //! \brief Write which of elements [first, first + count) of the column are valid (not null) into the words at
+        //! out, one bit per element, like the words of an indicator. Bits past count are zero.
+        void ReadValidity(std::size_t first, std::size_t count, std::uint64_t* out) const;
+
+        // ========================================
+        //  Reductions.
+        // ========================================
+
+        //! \brief The count, sum, mean, min, max and variance of the elements of the column, all found in a single
+        //! pass. Null elements, and NaNs, are skipped. Columns that are not numbers have empty statistics.
+        Statistics Describe() const;
+
+        //! \brief The sum of the elements of the column, skipping nulls and NaNs.
+        double Sum() const;
+
+        //! \brief The mean of the elements of the column, skipping nulls and NaNs. NaN if there are no such elements.
+        double Mean() const;
+
+        //! \brief The smallest element of the column, skipping nulls and NaNs. NaN if there are no such elements.
+        double Min() const;
+
+        //! \brief The largest element of the column, skipping nulls and NaNs. NaN if there are no such elements.
+        double Max() const;
+
+        //! \brief The sample variance of the elements of the column, skipping nulls and NaNs.
+        double Var() const;
+
+        //! \brief The number of elements of the column that are not null or NaN. This is the count that the reductions
+        //! are of, i.e. Describe().count for a column of numbers.
+        std::size_t Count() const;
+
         // ========================================
         //  Friend classes.
         // ========================================
@@ -181,7 +289,7 @@ namespace dataframe {
         //  Private constructors.
         // ========================================
         //! \brief Private constructor for a column of a specific dtype and size.
-        Column(DType dtype, IMapType index_map = nullptr, std::size_t size = 0);
+        Column(DType dtype, IndexMap index_map = IndexMap(), std::size_t size = 0);
 
         // ========================================
         //  Private helper functions.
@@ -195,6 +303,13 @@ namespace dataframe {
         //! subsets of a data frame, the size and full size will differ.
         std::size_t FullSize() const;
 
+        //! \brief Compare entries [first, first + count) of the column with a value, as the comparison operators do.
+        template<typename V>
+        Indicator Compare(CompareOp op, const V& value, std::size_t first, std::size_t count) const;
+
+        template<typename>
+        friend class ScalarComparison;
+
         // ========================================
         //  Private member data.
         // ========================================
@@ -202,8 +317,8 @@ namespace dataframe {
         //! \brief The box for this column.
         std::shared_ptr<Box> box_;
 
-        //! \brief The index map for this column.
-        IMapType index_map_;
+        //! \brief The entries of the column's data that this column sees.
+        IndexMap index_map_;
     };
 
     // ========================================
@@ -218,10 +333,10 @@ namespace dataframe {
     //  More definitions of template functions
     // ========================================
 
-    template<typename T>
+    template<typename T, typename = std::enable_if_t<!std::is_base_of<detail::ExpressionTag, T>::value>>
     Indicator operator<(const DataFrame::Column& col, const T& rhs) {
         std::size_t sz = col.Size();
-        auto c_col = col.GetConcrete<T>();
+        const auto c_col = col.ReadConcrete<T>();
         if (c_col.Size() == col.Size()) {
             Indicator output;
             output.reserve(sz);
@@ -236,12 +351,12 @@ namespace dataframe {
     template<typename T>
     void DataFrame::Column::Set(const T& value) {
         using S = ConvenienceType_t<T>;
+        box_->Own();
         auto ptr = std::dynamic_pointer_cast<ConcreteWrapper<S>>(box_->wrapper_);
         if (ptr) {
             ptr->SetAll(value, index_map_);
         } else {
-            box_->wrapper_->is_orphan = true; // Orphan the old wrapper.
-            box_->wrapper_ = std::make_shared<ConcreteWrapper<S>>(box_->wrapper_->Size(), value);
+            box_->SetWrapper(std::make_shared<ConcreteWrapper<S>>(box_->wrapper_->Size(), value));
         }
     }
 
@@ -255,19 +370,20 @@ namespace dataframe {
         }
 
         auto ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(box_->wrapper_);
-        if (!ptr) { // Need to change types.
-            box_->wrapper_->is_orphan = true; // Orphan the old wrapper.
-            box_->wrapper_ = std::shared_ptr<ConcreteWrapper<T>>(new ConcreteWrapper<T>(box_->wrapper_->Size()));
+        if (!ptr || box_->IsShared()) { // Need to change types, or to stop sharing the data.
+            box_->SetWrapper(std::shared_ptr<ConcreteWrapper<T>>(new ConcreteWrapper<T>(box_->wrapper_->Size())));
             ptr = util::reinterpret_pointer_cast<ConcreteWrapper<T>>(box_->wrapper_);
         }
         // Copy data
-        ptr->data_.resize(rhs.size());
+        ptr->Clear();
+        ptr->data_.Reserve(rhs.size());
         for (std::size_t i = 0; i < rhs.size(); ++i) {
-            ptr->data_[i] = rhs[i];
-            if (setting_none_col && index_map_) {
-                index_map_->push_back(index_map_->size());
+            ptr->data_.push_back(rhs[i]);
+            if (setting_none_col) {
+                index_map_.PushBack(i);
             }
         }
+        ptr->validity.Reset(rhs.size());
 
         return *this;
     }
@@ -280,16 +396,17 @@ namespace dataframe {
         }
 
         auto ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(box_->wrapper_);
-        if (!ptr) { // Need to change types.
-            box_->wrapper_->is_orphan = true; // Orphan the old wrapper.
-            box_->wrapper_ = std::make_shared<ConcreteWrapper<T>>(box_->wrapper_->Size());
+        if (!ptr || box_->IsShared()) { // Need to change types, or to stop sharing the data.
+            box_->SetWrapper(std::make_shared<ConcreteWrapper<T>>(box_->wrapper_->Size()));
             ptr = util::reinterpret_pointer_cast<ConcreteWrapper<T>>(box_->wrapper_);
         }
         // Copy data
-        auto it = rhs.begin();
-        for (std::size_t i = 0; i < rhs.size(); ++i, ++it) {
-            ptr->data_[i] = *it;
+        ptr->Clear();
+        ptr->data_.Reserve(rhs.size());
+        for (const auto& value : rhs) {
+            ptr->data_.push_back(value);
         }
+        ptr->validity.Reset(ptr->data_.size());
 
         return *this;
     }
@@ -306,6 +423,11 @@ namespace dataframe {
 
     template<typename T>
     DataFrame::Concrete<T> DataFrame::Column::GetConcrete() const {
+        if (!IsType<T>()) {
+            return DataFrame::Concrete<T>();
+        }
+        box_->Own();
+        box_->Compact();
         auto ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(box_->wrapper_);
         if (ptr) {
             return DataFrame::Concrete<T>(ptr, index_map_);
@@ -314,6 +436,16 @@ namespace dataframe {
         }
     }
 
+    template<typename T>
+    const DataFrame::Concrete<T> DataFrame::Column::ReadConcrete() const {
+        if (!IsType<T>()) {
+            return DataFrame::Concrete<T>();
+        }
+        // Only a wrapper with chunks is changed, by compacting it, and Compact copies a shared wrapper first.
+        box_->Compact();
+        return DataFrame::Concrete<T>(util::reinterpret_pointer_cast<ConcreteWrapper<T>>(box_->wrapper_), index_map_);
+    }
+
     template<typename T>
     std::vector<T> inline DataFrame::Column::CastToVector() const {
         return {};
@@ -353,7 +485,35 @@ namespace dataframe {
 
     template<typename T>
     std::set<T> DataFrame::Column::Unique() const {
-        return GetConcrete<T>().Unique();
+        return ReadConcrete<T>().Unique();
+    }
+
+    template<typename V>
+    Indicator DataFrame::Column::Compare(CompareOp op, const V& value, std::size_t first, std::size_t count) const {
+        const auto index_map = first == 0 && count == Size() ? index_map_ : index_map_.Slice(first, first + count, 0);
+        const auto& wrapper = *box_->wrapper_;
+        switch (op) {
+            case CompareOp::Eq:
+                return wrapper.eq(value, index_map);
+            case CompareOp::Ne:
+                return wrapper.ne(value, index_map);
+            default:
+                break;
+        }
+        // Strings can only be compared for equality.
+        if constexpr (!std::is_same<V, std::string>::value) {
+            switch (op) {
+                case CompareOp::Lt:
+                    return wrapper.lt(value, index_map);
+                case CompareOp::Gt:
+                    return wrapper.gt(value, index_map);
+                case CompareOp::Le:
+                    return wrapper.le(value, index_map);
+                default:
+                    return wrapper.ge(value, index_map);
+            }
+        }
+        return {};
     }
 
 }
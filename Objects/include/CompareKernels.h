@@ -0,0 +1,61 @@
+//
+// Created by Nathaniel Rupprecht on 6/5/21.
+//
+
+#ifndef __COMPARE_KERNELS_H__
+#define __COMPARE_KERNELS_H__
+
+#include <cstdint>
+#include <cstddef>
+
+namespace dataframe {
+
+    //! \brief The comparisons that can be made between the entries of a column and a value.
+    enum class CompareOp { Lt, Gt, Le, Ge, Eq, Ne };
+
+    //! \brief Vectorized kernels that compare arrays of numbers with a value, and write the results straight into the
+    //! words of a packed bitmask (like an Indicator's), 64 results to a word. The bits past the last result are zero.
+    //!
+    //! The instruction set is chosen once, at runtime: AVX2 if the processor has it, otherwise SSE2 on x86-64, and
+    //! otherwise plain loops. Floating point comparisons have the same results as the C++ operators, i.e. every
+    //! comparison with NaN is false except for !=.
+    namespace kernels {
+
+        //! \brief The instruction set that the kernels use on this machine.
+        enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+        //! \brief Get the instruction set that the kernels use. This is detected the first time it is needed.
+        SimdLevel GetSimdLevel();
+
+        //! \brief Compare data[0, size) with value, writing the results to out.
+        void Compare(CompareOp op, const std::int32_t *data, std::size_t size, std::int32_t value, std::uint64_t *out);
+        void Compare(CompareOp op, const std::int32_t *data, std::size_t size, double value, std::uint64_t *out);
+        void Compare(CompareOp op, const float *data, std::size_t size, float value, std::uint64_t *out);
+        void Compare(CompareOp op, const double *data, std::size_t size, double value, std::uint64_t *out);
+
+        //! \brief Compare data[indices[i]], for i in [0, size), with value, writing the results to out. This is the
+        //! path for views whose selection is not contiguous.
+        void CompareGather(CompareOp op, const std::int32_t *data, const std::size_t *indices, std::size_t size,
+                           std::int32_t value, std::uint64_t *out);
+        void CompareGather(CompareOp op, const std::int32_t *data, const std::size_t *indices, std::size_t size,
+                           double value, std::uint64_t *out);
+        void CompareGather(CompareOp op, const float *data, const std::size_t *indices, std::size_t size,
+                           float value, std::uint64_t *out);
+        void CompareGather(CompareOp op, const double *data, const std::size_t *indices, std::size_t size,
+                           double value, std::uint64_t *out);
+
+        //! \brief Compare lhs[i] with rhs[i], for i in [0, size), writing the results to out. The arrays may hold
+        //! std::int32_t, float, or double, in any combination. Entries of the same type are compared as that type, and
+        //! entries of different types are compared as doubles, which hold any int32 or float exactly.
+        template<typename L, typename R>
+        void CompareColumns(CompareOp op, const L *lhs, const R *rhs, std::size_t size, std::uint64_t *out);
+
+        //! \brief Compare lhs[lhs_indices[i]] with rhs[rhs_indices[i]], for i in [0, size), writing the results to out.
+        //! This is the path for views whose selections are not contiguous.
+        template<typename L, typename R>
+        void CompareColumnsGather(CompareOp op, const L *lhs, const std::size_t *lhs_indices, const R *rhs,
+                                  const std::size_t *rhs_indices, std::size_t size, std::uint64_t *out);
+    }
+
+}
+#endif // __COMPARE_KERNELS_H__
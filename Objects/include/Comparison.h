@@ -7,10 +7,13 @@
 
 #include <vector>
 #include <type_traits>
+#include <functional>
+#include <limits>
+#include <algorithm>
 #include "DFVector.h"
-
-using Indicator = std::vector<bool>;
-using IMapType = std::shared_ptr<std::vector<std::size_t>>;
+#include "IndexMap.h"
+#include "Indicator.h"
+#include "CompareKernels.h"
 
 namespace dataframe {
     // ========================================
@@ -34,14 +37,138 @@ namespace dataframe {
     //  Object to do comparisons between values and dfvectors of potentially different types.
     // ========================================
 
+    namespace detail {
+        //! \brief An integer of any signed or unsigned type, which compares with others by value. Negative integers
+        //! are less than all others, and integers of the same sign compare as 64 bit unsigned integers, which keeps
+        //! their order. This is what signed and unsigned 64 bit integers are compared in, since neither type holds
+        //! every value of the other.
+        struct AnyInteger {
+            template<typename Integer, typename = std::enable_if_t<std::is_integral<Integer>::value>>
+            AnyInteger(Integer value) : non_negative(!(value < 0)), bits(static_cast<std::uint64_t>(value)) {}
+
+            friend bool operator<(const AnyInteger &lhs, const AnyInteger &rhs) {
+                return lhs.non_negative != rhs.non_negative ? rhs.non_negative : lhs.bits < rhs.bits;
+            }
+
+            friend bool operator>(const AnyInteger &lhs, const AnyInteger &rhs) { return rhs < lhs; }
+
+            friend bool operator<=(const AnyInteger &lhs, const AnyInteger &rhs) { return !(rhs < lhs); }
+
+            friend bool operator>=(const AnyInteger &lhs, const AnyInteger &rhs) { return !(lhs < rhs); }
+
+            friend bool operator==(const AnyInteger &lhs, const AnyInteger &rhs) {
+                return lhs.non_negative == rhs.non_negative && lhs.bits == rhs.bits;
+            }
+
+            friend bool operator!=(const AnyInteger &lhs, const AnyInteger &rhs) { return !(lhs == rhs); }
+
+            bool non_negative;
+            std::uint64_t bits;
+        };
+
+        //! \brief The type that two integers, of types L and R, are compared in. This is long long if both are signed,
+        //! or if the unsigned one is narrower than a long long, unsigned long long if both are unsigned, and
+        //! otherwise AnyInteger, so that every pair of integers compares by value.
+        template<typename L, typename R>
+        using IntegerComparisonType = std::conditional_t<
+                std::is_signed<L>::value == std::is_signed<R>::value,
+                std::conditional_t<std::is_signed<L>::value, long long, unsigned long long>,
+                std::conditional_t<(std::is_unsigned<L>::value ? sizeof(L) : sizeof(R)) < sizeof(long long),
+                                   long long, AnyInteger>>;
+
+        //! \brief The type that a value is converted to before it is compared with the entries of a dfvector. This is
+        //! usually the type of the entries. Integer entries are compared with numbers in a type that holds any of
+        //! them instead, so that a value out of range of a narrow integer type does not wrap around into its range,
+        //! and a floating point value is not truncated.
+        template<typename value_type, typename target_type, typename = void>
+        struct ComparisonType {
+            using type = target_type;
+        };
+
+        template<typename value_type, typename target_type>
+        struct ComparisonType<value_type, target_type, std::enable_if_t<
+                std::is_integral<target_type>::value && !std::is_same<target_type, bool>::value
+                && std::is_arithmetic<value_type>::value && !std::is_same<value_type, bool>::value>> {
+            using type = std::conditional_t<std::is_floating_point<value_type>::value, double,
+                                            IntegerComparisonType<value_type, target_type>>;
+        };
+    }
+
+    namespace detail {
+        //! \brief Call f with the function object for a comparison, so the comparison is decided once for a whole
+        //! dfvector instead of once per entry.
+        template<typename Function>
+        decltype(auto) WithComparison(CompareOp op, Function &&f) {
+            switch (op) {
+                case CompareOp::Lt:
+                    return f(std::less<>());
+                case CompareOp::Gt:
+                    return f(std::greater<>());
+                case CompareOp::Le:
+                    return f(std::less_equal<>());
+                case CompareOp::Ge:
+                    return f(std::greater_equal<>());
+                case CompareOp::Eq:
+                    return f(std::equal_to<>());
+                default:
+                    return f(std::not_equal_to<>());
+            }
+        }
+
+        //! \brief Whether there are vectorized comparison kernels for entries of a type.
+        template<typename T>
+        constexpr bool kHasCompareKernel = std::is_same<T, std::int32_t>::value || std::is_same<T, float>::value
+                                           || std::is_same<T, double>::value;
+
+        //! \brief The number of entries of a view that are gathered before they are handed to a kernel. This is a
+        //! multiple of 64, so every batch fills whole words of the output.
+        constexpr std::size_t kGatherBatch = 1024;
+
+        //! \brief The type that the entries of two columns are compared in. Numbers of the same type are compared as
+        //! that type. Numbers of different types are compared as doubles if either is floating point, and otherwise
+        //! in their IntegerComparisonType, so that signed and unsigned integers compare by value. This is void for
+        //! other types, whose entries are compared as they are.
+        template<typename L, typename R, typename = void>
+        struct ColumnComparisonType {
+            using type = void;
+        };
+
+        template<typename L, typename R>
+        struct ColumnComparisonType<L, R, std::enable_if_t<
+                std::is_arithmetic<L>::value && !std::is_same<L, bool>::value
+                && std::is_arithmetic<R>::value && !std::is_same<R, bool>::value>> {
+            using type = std::conditional_t<std::is_same<L, R>::value, L, std::conditional_t<
+                    std::is_floating_point<L>::value || std::is_floating_point<R>::value, double,
+                    IntegerComparisonType<L, R>>>;
+        };
+    }
+
+    //! \brief Compare the entries of two arrays, through two selections of the same size, entry i of one with entry i
+    //! of the other. The results are written into the words of out. The arrays may hold std::int32_t, float, or
+    //! double. If both selections are contiguous, the arrays are compared in place, and otherwise the entries of both
+    //! are gathered a batch at a time.
+    template<typename L, typename R>
+    void CompareSelections(CompareOp op, const L *lhs, const IndexMap &lhs_map, const R *rhs, const IndexMap &rhs_map,
+                           std::size_t size, std::uint64_t *out) {
+        if (lhs_map.IsContiguous() && rhs_map.IsContiguous()) {
+            kernels::CompareColumns(op, lhs + lhs_map.First(), rhs + rhs_map.First(), size, out);
+            return;
+        }
+        std::size_t lhs_batch[detail::kGatherBatch], rhs_batch[detail::kGatherBatch];
+        for (std::size_t first = 0; first < size; first += detail::kGatherBatch) {
+            const auto count = std::min(detail::kGatherBatch, size - first);
+            kernels::CompareColumnsGather(op, lhs, lhs_map.GetIndices(first, count, lhs_batch),
+                                          rhs, rhs_map.GetIndices(first, count, rhs_batch), count, out + first / 64);
+        }
+    }
+
     namespace {
         template<typename value_type, typename target_type, bool is_castable>
         struct DoComparisonHelper {
-            template<typename Binary>
             static Indicator compare(
-                    Binary &&op,
+                    CompareOp op,
                     const DFVector<target_type> &data,
-                    const IMapType& index_map,
+                    const IndexMap& index_map,
                     const value_type &value) {
                 return {};
             }
@@ -49,25 +176,72 @@ namespace dataframe {
 
         template<typename value_type, typename target_type>
         struct DoComparisonHelper<value_type, target_type, true> {
-            template<typename Binary>
+            using comparison_type = typename detail::ComparisonType<value_type, target_type>::type;
+
             static Indicator compare(
-                    Binary &&op,
+                    CompareOp op,
                     const DFVector<target_type> &data,
-                    const IMapType& index_map,
+                    const IndexMap& index_map,
                     const value_type &value) {
-                Indicator output;
-                if (index_map) { // Index map: use only entries in the index map.
-                    output.reserve(index_map->size());
-                    for (auto i : *index_map) {
-                        output.push_back(op(data[i], static_cast<target_type>(value)));
+                const auto target = static_cast<comparison_type>(value);
+                const auto size = index_map.Size(data.size());
+                if constexpr (detail::kHasCompareKernel<target_type>
+                              && !std::is_same<comparison_type, detail::AnyInteger>::value) {
+                    if constexpr (std::is_same<comparison_type, long long>::value) {
+                        // A value outside the range of the entries' type compares the same way with all of them.
+                        if (target < std::numeric_limits<target_type>::min()) {
+                            return Indicator(size, op == CompareOp::Gt || op == CompareOp::Ge || op == CompareOp::Ne);
+                        }
+                        if (std::numeric_limits<target_type>::max() < target) {
+                            return Indicator(size, op == CompareOp::Lt || op == CompareOp::Le || op == CompareOp::Ne);
+                        }
+                        return Kernel(op, data, index_map, size, static_cast<target_type>(target));
                     }
-                }
-                else { // No index map, use all data entries.
-                    output.reserve(data.size());
-                    for (std::size_t i = 0; i < data.size(); ++i) {
-                        output.push_back(op(data[i], static_cast<target_type>(value)));
+                    else {
+                        return Kernel(op, data, index_map, size, target);
                     }
                 }
+                else {
+                    return detail::WithComparison(op, [&](auto compare) {
+                        const auto &entries = Entries(data);
+                        // Full column or a range: compare a contiguous block of entries.
+                        if (index_map.IsContiguous()) {
+                            const auto first = index_map.First();
+                            return Indicator::Generate(size, [&](std::size_t i) {
+                                return compare(entries[first + i], target);
+                            });
+                        }
+                        // Use only the entries in the index map.
+                        Indicator output;
+                        output.reserve(size);
+                        index_map.ForEach(size, [&](std::size_t i) {
+                            output.push_back(compare(entries[i], target));
+                        });
+                        return output;
+                    });
+                }
+            }
+
+        private:
+            //! \brief Compare with the vectorized kernels, which write straight into the words of the output.
+            //! Contiguous selections are compared in place, and other selections gather the entries by index.
+            template<typename Value>
+            static Indicator Kernel(CompareOp op, const DFVector<target_type> &data, const IndexMap& index_map,
+                                    std::size_t size, Value value) {
+                Indicator output(size);
+                auto *out = output.Words().data();
+                const auto *entries = data.data();
+                if (index_map.IsContiguous()) {
+                    kernels::Compare(op, entries + index_map.First(), size, value, out);
+                    return output;
+                }
+                // Gather the entries a batch at a time. Bitmap selections are turned into indices for each batch.
+                std::size_t batch[detail::kGatherBatch];
+                for (std::size_t first = 0; first < size; first += detail::kGatherBatch) {
+                    const auto count = std::min(detail::kGatherBatch, size - first);
+                    kernels::CompareGather(op, entries, index_map.GetIndices(first, count, batch), count, value,
+                                           out + first / 64);
+                }
                 return output;
             }
         };
@@ -76,48 +250,5 @@ namespace dataframe {
     template<typename value_type, typename target_type>
     struct DoComparison : public DoComparisonHelper<value_type, target_type, is_castable<value_type, target_type>::value> {};
 
-    // ========================================
-    //  Helpful operators for combining or modifying Indicators.
-    // ========================================
-
-    inline Indicator operator&(const Indicator& lhs, const Indicator& rhs) {
-        std::size_t sz = std::min(lhs.size(), rhs.size());
-        Indicator output;
-        output.resize(sz);
-        for (std::size_t i = 0; i < sz; ++i) {
-            output[i] = lhs[i] && rhs[i];
-        }
-        return output;
-    }
-
-    inline Indicator operator|(const Indicator& lhs, const Indicator& rhs) {
-        std::size_t sz = std::min(lhs.size(), rhs.size());
-        Indicator output;
-        output.resize(sz);
-        for (std::size_t i = 0; i < sz; ++i) {
-            output[i] = lhs[i] || rhs[i];
-        }
-        return output;
-    }
-
-    inline Indicator operator^(const Indicator& lhs, const Indicator& rhs) {
-        std::size_t sz = std::min(lhs.size(), rhs.size());
-        Indicator output;
-        output.resize(sz);
-        for (std::size_t i = 0; i < sz; ++i) {
-            output[i] = lhs[i] ^ rhs[i];
-        }
-        return output;
-    }
-
-    inline Indicator operator~(const Indicator& lhs) {
-        Indicator output;
-        output.resize(lhs.size());
-        for (std::size_t i = 0; i < lhs.size(); ++i) {
-            output[i] = !lhs[i];
-        }
-        return output;
-    }
-
 }
 #endif // __COMPARISON_H__
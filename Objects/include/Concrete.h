@@ -20,6 +20,8 @@ namespace dataframe {
         // ========================================
 
         using value_type = T;
+        using reference = typename DFVector<T>::reference;
+        using const_reference = typename DFVector<T>::const_reference;
 
         // ========================================
         //  Constructors.
@@ -35,21 +37,13 @@ namespace dataframe {
         //! \brief Return the size of the concrete column. Because of masking, this may be less than the size
         //! of the data vector.
         std::size_t Size() const {
-            if (index_map_) {
-                return index_map_->size();
-            } else {
-                return wrapper_->data_.size();
-            }
+            return index_map_.Size(wrapper_->data_.size());
         }
 
         //! \brief Return whether the concrete column is empty. Because of masking, this may be true even when the
         //! data vector is not empty.
         bool Empty() const {
-            if (index_map_) {
-                return index_map_->empty();
-            } else {
-                return wrapper_->data_.empty();
-            }
+            return Size() == 0;
         }
 
         //! \brief Get the dtype of the data.
@@ -59,33 +53,72 @@ namespace dataframe {
         //! concrete column references changes in the DataFrame.
         bool IsOrphan() const { return wrapper_->is_orphan; }
 
-        //! \brief Reference access.
-        T& operator[](std::size_t index) {
-            if (index_map_) {
-                return wrapper_->data_[(*index_map_)[index]];
-            } else { // A null index map means we don't need an index map.
-                return wrapper_->data_[index];
-            }
+        //! \brief Reference access. For strings, this is a reference that reads as a string_view and can be assigned
+        //! any string.
+        reference operator[](std::size_t index) {
+            return wrapper_->data_[index_map_[index]];
         }
 
-        //! \brief Constant access.
-        const T& operator[](std::size_t index) const {
-            if (index_map_) {
-                return wrapper_->data_[(*index_map_)[index]];
-            } else { // A null index map means we don't need an index map.
-                return wrapper_->data_[index];
-            }
+        //! \brief Constant access. For strings, this is a string_view into the column's buffer.
+        const_reference operator[](std::size_t index) const {
+            return std::as_const(wrapper_->data_)[index_map_[index]];
+        }
+
+        //! \brief Whether an entry is null.
+        bool IsNull(std::size_t index) const {
+            return !wrapper_->validity.IsValid(index_map_[index]);
+        }
+
+        //! \brief Set whether an entry is null. The value of the entry is not changed.
+        void SetNull(std::size_t index, bool is_null = true) {
+            wrapper_->validity.Set(index_map_[index], !is_null);
         }
 
         //! \brief Get a set of all the unique values in the concrete column.
         std::set<T> Unique() const {
             std::set<T> output;
-            for (std::size_t i = 0; i < Size(); ++i) {
-                output.insert((*this)[i]);
-            }
+            const auto& data = wrapper_->data_;
+            index_map_.ForEach(Size(), [&](std::size_t index) {
+                output.emplace(data[index]);
+            });
             return output;
         }
 
+        // ========================================
+        //  Reductions.
+        // ========================================
+
+        //! \brief The count, sum, mean, min, max and variance of the entries, all found in a single pass. Null
+        //! entries, and NaNs, are skipped.
+        Statistics Describe() const { return wrapper_->Describe(index_map_, true); }
+
+        //! \brief The sum of the entries, skipping nulls and NaNs.
+        double Sum() const { return wrapper_->Describe(index_map_, false).sum; }
+
+        //! \brief The mean of the entries, skipping nulls and NaNs.
+        double Mean() const { return wrapper_->Describe(index_map_, false).mean; }
+
+        //! \brief The smallest entry, skipping nulls and NaNs.
+        double Min() const { return wrapper_->Describe(index_map_, false).min; }
+
+        //! \brief The largest entry, skipping nulls and NaNs.
+        double Max() const { return wrapper_->Describe(index_map_, false).max; }
+
+        //! \brief The sample variance of the entries, skipping nulls and NaNs.
+        double Var() const { return Describe().variance; }
+
+        //! \brief The number of entries that are not null or NaN, as for DataFrame::Column::Count.
+        std::size_t Count() const {
+            if constexpr (std::is_floating_point<T>::value) {
+                return wrapper_->Describe(index_map_, false).count;
+            }
+            std::size_t count = 0;
+            index_map_.ForEach(Size(), [&](std::size_t index) {
+                count += wrapper_->validity.IsValid(index);
+            });
+            return count;
+        }
+
         // ========================================
         //  Friend classes.
         // ========================================
@@ -97,12 +130,13 @@ namespace dataframe {
         using WrapperType = DataFrame::Column::ConcreteWrapper<T>;
 
         //! \brief Create a concrete column from a concrete wrapper and an index map.
-        explicit Concrete(std::shared_ptr<WrapperType> wrapper, IMapType index_map)
+        explicit Concrete(std::shared_ptr<WrapperType> wrapper, IndexMap index_map)
             : wrapper_(std::move(wrapper)), index_map_(std::move(index_map)) {}
 
         //! \brief Private method to add data to the concrete column. Only a DataFrame can add data to columns.
         void push_back(const T& value) {
             wrapper_->data_.push_back(value);
+            wrapper_->validity.PushBack(true);
         }
 
         //! \brief Return the full size of underlying column the concrete points to. If this concrete was selected as a
@@ -113,15 +147,15 @@ namespace dataframe {
 
         //! \brief Return the index map and the next index that should be inserted into the index map (if an index map
         //! is needed).
-        std::pair<std::vector<std::size_t>*, std::size_t> GetIndexData() const {
-            return std::make_pair(index_map_.get(), FullSize());
+        std::pair<IndexMap, std::size_t> GetIndexData() const {
+            return std::make_pair(index_map_, FullSize());
         }
 
         //! \brief A pointer to the concrete wrapper that contains the data.
         std::shared_ptr<WrapperType> wrapper_;
 
-        //! \brief A pointer to the index map.
-        IMapType index_map_;
+        //! \brief The entries of the column that the concrete column sees.
+        IndexMap index_map_;
     };
 
 }
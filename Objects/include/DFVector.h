@@ -5,103 +5,284 @@
 #ifndef __DF_VECTOR_H__
 #define __DF_VECTOR_H__
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "DTypes.h"
 
 namespace dataframe {
 
-//! \brief A type that is a simple wrapper around another type. This is used to get around the
-//! fact that std::vector<bool> is specialized, and lacks a reference access operator or .at function.
+//! \brief The storage of a column: a contiguous buffer of entries, aligned to kAlignment bytes.
+//!
+//! Unlike a std::vector, a DFVector<bool> stores one (addressable) bool per byte, so every type can be accessed by
+//! reference, and every type's data can be handed to kernels as a plain pointer. Entries of trivially copyable types
+//! are copied and moved with memcpy.
+//!
+//! A vector of trivially copyable entries can also adopt entries that are stored elsewhere, like in a memory mapped
+//! file, instead of copying them. Adopted entries are copied into a buffer of the vector's own the first time the
+//! vector is modified, or its entries are accessed through anything other than a constant reference.
 template<typename T>
-struct Holder {
+class DFVector {
+public:
     // ========================================
-    //  Constructors
+    //  Typedefs
     // ========================================
+    using value_type = T;
+    using self_type = DFVector<value_type>;
+    using reference = T &;
+    using const_reference = const T &;
 
-    Holder() = default;
-
-    Holder(const Holder<T> &rhs) : value_(rhs.value_) {}
-
-    Holder(Holder<T> &&rhs) noexcept: value_(std::move(rhs.value_)) {}
-
-    explicit Holder(const T &value) : value_(value) {}
-
-    explicit Holder(T &&value) : value_(std::move(value)) {}
+    //! \brief The alignment of the data, in bytes. This is the size of a cache line, and of the widest SIMD registers.
+    static constexpr std::size_t kAlignment = 64;
 
     // ========================================
-    //  Logicial operators.
+    //  Constructors.
     // ========================================
+    DFVector() = default;
 
-    bool operator==(const Holder &rhs) const { return value_ == rhs.value_; }
+    explicit DFVector(std::size_t sz) { resize(sz); }
 
-    // ========================================
-    //  Assignment.
-    // ========================================
+    DFVector(std::size_t sz, const T &value) {
+        Reserve(sz);
+        std::uninitialized_fill_n(data_, sz, value);
+        size_ = sz;
+    }
 
-    Holder &operator=(const Holder &rhs) {
-        value_ = rhs.value_;
+    DFVector(const DFVector &rhs) { *this = rhs; }
+
+    DFVector(DFVector &&rhs) noexcept
+            : data_(rhs.data_), size_(rhs.size_), capacity_(rhs.capacity_), owner_(std::move(rhs.owner_)) {
+        rhs.data_ = nullptr;
+        rhs.size_ = rhs.capacity_ = 0;
+    }
+
+    DFVector &operator=(const DFVector &rhs) {
+        if (this != &rhs) {
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                // A copy of adopted entries adopts them too.
+                if (rhs.owner_) {
+                    Adopt(rhs.data_, rhs.size_, rhs.owner_);
+                    return *this;
+                }
+            }
+            resize(0);
+            append(rhs);
+        }
         return *this;
     }
 
-    Holder &operator=(Holder &&rhs) {
-        value_ = std::move(rhs.value_);
+    DFVector &operator=(DFVector &&rhs) noexcept {
+        if (this != &rhs) {
+            Deallocate();
+            data_ = rhs.data_, size_ = rhs.size_, capacity_ = rhs.capacity_;
+            owner_ = std::move(rhs.owner_);
+            rhs.data_ = nullptr;
+            rhs.size_ = rhs.capacity_ = 0;
+        }
         return *this;
     }
 
+    ~DFVector() { Deallocate(); }
+
     // ========================================
-    //  Data.
+    //  Functions to allow DFVector to operate like a std::vector when we need it to.
     // ========================================
 
-    //! \brief The actual bid of data contained in the Holder.
-    T value_;
-};
+    std::size_t size() const { return size_; }
 
-template<typename T>
-class DFVector {
-public:
-    // ========================================
-    //  Typedefs
-    // ========================================
-    using value_type = T;
-    using CType = std::vector<Holder<value_type>>;
-    using self_type = DFVector<value_type>;
+    bool empty() const { return size_ == 0; }
 
-    // ========================================
-    //  Constructors.
-    // ========================================
-    DFVector() = default;
+    const T &operator[](std::size_t index) const { return data_[index]; }
+
+    T &operator[](std::size_t index) {
+        Own();
+        return data_[index];
+    }
+
+    bool operator==(const DFVector<T> &rhs) const {
+        return size_ == rhs.size_ && std::equal(data_, data_ + size_, rhs.data_);
+    }
+
+    void push_back(const T &value) {
+        Own();
+        if (size_ == capacity_) {
+            // The value might be an entry of this vector, so copy it before reallocating.
+            T copy(value);
+            Reallocate(Grow(size_ + 1));
+            new(data_ + size_) T(std::move(copy));
+        }
+        else {
+            new(data_ + size_) T(value);
+        }
+        ++size_;
+    }
 
-    explicit DFVector(std::size_t sz) : data_(sz) {}
+    void push_back(T &&value) {
+        Own();
+        if (size_ == capacity_) {
+            T copy(std::move(value));
+            Reallocate(Grow(size_ + 1));
+            new(data_ + size_) T(std::move(copy));
+        }
+        else {
+            new(data_ + size_) T(std::move(value));
+        }
+        ++size_;
+    }
+
+    void append(const self_type &rhs) {
+        if (rhs.size_ == 0) {
+            return;
+        }
+        Own();
+        if (capacity_ < size_ + rhs.size_) {
+            Reallocate(Grow(size_ + rhs.size_));
+        }
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            std::memcpy(static_cast<void *>(data_ + size_), rhs.data_, rhs.size_ * sizeof(T));
+        }
+        else {
+            std::uninitialized_copy(rhs.data_, rhs.data_ + rhs.size_, data_ + size_);
+        }
+        size_ += rhs.size_;
+    }
+
+    void resize(std::size_t sz) {
+        if (owner_ && sz == 0) {
+            // There is no need to copy adopted entries just to drop them.
+            Deallocate();
+            return;
+        }
+        Own();
+        if (sz < size_) {
+            std::destroy(data_ + sz, data_ + size_);
+        }
+        else if (size_ < sz) {
+            if (capacity_ < sz) {
+                Reallocate(Grow(sz));
+            }
+            // Value initialization, so arithmetic types are zeroed.
+            std::uninitialized_value_construct(data_ + size_, data_ + sz);
+        }
+        size_ = sz;
+    }
+
+    void Reserve(std::size_t sz) {
+        if (capacity_ < sz) {
+            Reallocate(sz);
+        }
+    }
+
+    //! \brief Refer to size entries that are stored elsewhere, in memory that owner keeps alive, instead of copying
+    //! them. The data should be aligned to kAlignment bytes for the fastest access.
+    void Adopt(const T *data, std::size_t size, std::shared_ptr<const void> owner) {
+        static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable entries can be adopted.");
+        Deallocate();
+        data_ = const_cast<T *>(data);
+        size_ = capacity_ = size;
+        owner_ = std::move(owner);
+    }
 
-    DFVector(std::size_t sz, const T &value) : data_(sz, Holder<T>(value)) {};
+    //! \brief Whether the entries were adopted, and are still stored elsewhere.
+    bool IsAdopted() const { return owner_ != nullptr; }
 
     // ========================================
-    //  Functions to allow DFVector to operate like a std::vector when we need it to.
+    //  Raw access.
     // ========================================
 
-    std::size_t size() const { return data_.size(); }
+    //! \brief A pointer to the (aligned) first entry.
+    T *data() {
+        Own();
+        return data_;
+    }
 
-    bool empty() const { return data_.empty(); }
+    //! \brief A constant pointer to the (aligned) first entry.
+    const T *data() const { return data_; }
 
-    T operator[](std::size_t index) const { return data_[index].value_; }
+    T *begin() {
+        Own();
+        return data_;
+    }
 
-    T &operator[](std::size_t index) { return data_[index].value_; }
+    T *end() {
+        Own();
+        return data_ + size_;
+    }
 
-    bool operator==(const DFVector<T> &rhs) const { return data_ == rhs.data_; }
+    const T *begin() const { return data_; }
 
-    void push_back(const T &value) { data_.push_back(Holder<T>(value)); }
+    const T *end() const { return data_ + size_; }
 
-    void push_back(T &&value) { data_.push_back(Holder<T>(std::move(value))); }
+private:
+    //! \brief The capacity to grow to, to fit at least sz entries.
+    std::size_t Grow(std::size_t sz) const {
+        return std::max(sz, 2 * capacity_);
+    }
 
-    void append(const self_type &rhs) {
-        data_.insert(data_.end(), rhs.data_.begin(), rhs.data_.end());
+    //! \brief Copy adopted entries into a buffer of the vector's own, so they can be modified.
+    void Own() {
+        if (owner_) {
+            Reallocate(size_);
+        }
     }
 
-    void resize(std::size_t sz) { data_.resize(sz); }
+    //! \brief Move the entries into a new buffer that can hold capacity entries.
+    void Reallocate(std::size_t capacity) {
+        auto data = static_cast<T *>(::operator new(capacity * sizeof(T), std::align_val_t(kAlignment)));
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            if (size_) {
+                std::memcpy(static_cast<void *>(data), data_, size_ * sizeof(T));
+            }
+        }
+        else {
+            std::uninitialized_move(data_, data_ + size_, data);
+            std::destroy(data_, data_ + size_);
+        }
+        if (data_ && !owner_) {
+            ::operator delete(data_, std::align_val_t(kAlignment));
+        }
+        owner_.reset();
+        data_ = data;
+        capacity_ = capacity;
+    }
+
+    //! \brief Destroy the entries and release the buffer.
+    void Deallocate() {
+        if (data_ && !owner_) {
+            std::destroy(data_, data_ + size_);
+            ::operator delete(data_, std::align_val_t(kAlignment));
+        }
+        owner_.reset();
+        data_ = nullptr;
+        size_ = capacity_ = 0;
+    }
+
+    // ========================================
+    //  Data.
+    // ========================================
+
+    //! \brief The entries.
+    T *data_ = nullptr;
 
-    void Reserve(std::size_t sz) { data_.reserve(sz); }
+    //! \brief The number of entries.
+    std::size_t size_ = 0;
 
-    //! \brief Non-specialized DFVector<T>'s are just wrappers for a std::vectors<Holder<T>>.
-    CType data_;
+    //! \brief The number of entries that fit in the buffer.
+    std::size_t capacity_ = 0;
+
+    //! \brief If the entries were adopted, keeps the memory they are stored in alive. Null otherwise.
+    std::shared_ptr<const void> owner_;
 };
 
 //! \brief Specialization of DFVector. Since NoneDType is just a placeholder, there is no point
@@ -113,6 +294,8 @@ public:
     using value_type = NoneDType;
     using CType = NoneDType;
     using self_type = DFVector<NoneDType>;
+    using reference = NoneDType &;
+    using const_reference = const NoneDType &;
 
 
     DFVector() = default;
@@ -125,7 +308,7 @@ public:
 
     bool empty() const { return size_ == 0; }
 
-    NoneDType operator[](std::size_t index) const { return x; }
+    const NoneDType &operator[](std::size_t index) const { return x; }
 
     NoneDType &operator[](std::size_t index) { return x; }
 
@@ -160,6 +343,8 @@ public:
     using value_type = EmptyDType;
     using CType = EmptyDType;
     using self_type = DFVector<EmptyDType>;
+    using reference = EmptyDType &;
+    using const_reference = const EmptyDType &;
 
     DFVector() = default;
 
@@ -171,7 +356,7 @@ public:
 
     bool empty() const { return size_ == 0; }
 
-    EmptyDType operator[](std::size_t index) const { return x; }
+    const EmptyDType &operator[](std::size_t index) const { return x; }
 
     EmptyDType &operator[](std::size_t index) { return x; }
 
@@ -197,5 +382,432 @@ private:
     std::size_t size_;
 };
 
+//! \brief Specialization of DFVector for strings. Instead of one separately allocated std::string per entry, the bytes
+//! of all the strings are stored back to back in one buffer, along with the offset where each string ends, like an
+//! Arrow string array. Adding a string copies its bytes onto the end of the buffer, copying or appending a vector is a
+//! couple of memcpys, and entries are read as string_views into the buffer.
+//!
+//! Entries are assigned through a StringReference. Assigning a string of a different length to an entry other than
+//! the last one moves the bytes of all the entries after it, so vectors should be built with push_back.
+template<>
+class DFVector<std::string> {
+public:
+    // ========================================
+    //  Typedefs
+    // ========================================
+
+    using value_type = std::string;
+    using self_type = DFVector<std::string>;
+
+    //! \brief A reference to an entry, which reads as a string_view and can be assigned any string.
+    class StringReference {
+    public:
+        StringReference(self_type *vector, std::size_t index) : vector_(vector), index_(index) {}
+
+        StringReference &operator=(std::string_view value) {
+            vector_->Set(index_, value);
+            return *this;
+        }
+
+        StringReference &operator=(const StringReference &rhs) {
+            return *this = static_cast<std::string_view>(rhs);
+        }
+
+        operator std::string_view() const { return std::as_const(*vector_)[index_]; }
+
+        //! \brief Copy the entry into a std::string.
+        std::string str() const { return std::string(static_cast<std::string_view>(*this)); }
+
+        friend bool operator==(const StringReference &lhs, const StringReference &rhs) {
+            return std::string_view(lhs) == std::string_view(rhs);
+        }
+
+        friend bool operator==(const StringReference &lhs, std::string_view rhs) { return std::string_view(lhs) == rhs; }
+
+        friend bool operator==(std::string_view lhs, const StringReference &rhs) { return lhs == std::string_view(rhs); }
+
+        friend bool operator!=(const StringReference &lhs, std::string_view rhs) { return std::string_view(lhs) != rhs; }
+
+        friend bool operator<(const StringReference &lhs, std::string_view rhs) { return std::string_view(lhs) < rhs; }
+
+        friend std::ostream &operator<<(std::ostream &out, const StringReference &ref) {
+            return out << std::string_view(ref);
+        }
+
+    private:
+        self_type *vector_;
+        std::size_t index_;
+    };
+
+    using reference = StringReference;
+    using const_reference = std::string_view;
+
+    // ========================================
+    //  Constructors.
+    // ========================================
+
+    DFVector() = default;
+
+    explicit DFVector(std::size_t sz) { resize(sz); }
+
+    DFVector(std::size_t sz, std::string_view value) {
+        Reserve(sz);
+        bytes_.Reserve(sz * value.size());
+        for (std::size_t i = 0; i < sz; ++i) {
+            push_back(value);
+        }
+    }
+
+    // ========================================
+    //  Functions to allow DFVector to operate like a std::vector when we need it to.
+    // ========================================
+
+    std::size_t size() const { return ends_.size(); }
+
+    bool empty() const { return ends_.empty(); }
+
+    std::string_view operator[](std::size_t index) const {
+        auto begin = Begin(index);
+        return {bytes_.data() + begin, static_cast<std::size_t>(ends_[index] - begin)};
+    }
+
+    StringReference operator[](std::size_t index) { return {this, index}; }
+
+    bool operator==(const self_type &rhs) const {
+        return ends_ == rhs.ends_ && bytes_ == rhs.bytes_;
+    }
+
+    void push_back(std::string_view value) {
+        if (bytes_.data() <= value.data() && value.data() < bytes_.data() + bytes_.size()) {
+            // The value is an entry of this vector, and the buffer may move.
+            std::string copy(value);
+            push_back(copy);
+            return;
+        }
+        auto begin = bytes_.size();
+        bytes_.resize(begin + value.size());
+        if (!value.empty()) {
+            std::memcpy(bytes_.data() + begin, value.data(), value.size());
+        }
+        ends_.push_back(bytes_.size());
+    }
+
+    void append(const self_type &rhs) {
+        if (&rhs == this) {
+            self_type copy(rhs);
+            append(copy);
+            return;
+        }
+        // The offsets of the strings that are appended are shifted past the strings already in the buffer.
+        auto shift = static_cast<std::uint64_t>(bytes_.size());
+        ends_.Reserve(ends_.size() + rhs.ends_.size());
+        for (auto end : rhs.ends_) {
+            ends_.push_back(end + shift);
+        }
+        bytes_.append(rhs.bytes_);
+    }
+
+    void resize(std::size_t sz) {
+        if (sz < size()) {
+            ends_.resize(sz);
+            bytes_.resize(sz ? ends_[sz - 1] : 0);
+            return;
+        }
+        // New entries are empty strings.
+        ends_.Reserve(sz);
+        while (size() < sz) {
+            ends_.push_back(bytes_.size());
+        }
+    }
+
+    void Reserve(std::size_t sz) { ends_.Reserve(sz); }
+
+    // ========================================
+    //  String specific functions.
+    // ========================================
+
+    //! \brief Set an entry to a new string.
+    void Set(std::size_t index, std::string_view value) {
+        if (bytes_.data() <= value.data() && value.data() < bytes_.data() + bytes_.size()) {
+            // The value overlaps the buffer, which will be changed.
+            std::string copy(value);
+            Set(index, copy);
+            return;
+        }
+        auto begin = Begin(index), end = ends_[index];
+        auto length = static_cast<std::uint64_t>(value.size());
+        if (begin + length != end) {
+            // Move the entries after this one to make exactly enough space for the new string.
+            auto tail = bytes_.size() - end;
+            if (end < begin + length) {
+                bytes_.resize(bytes_.size() + (begin + length - end));
+            }
+            std::memmove(bytes_.data() + begin + length, bytes_.data() + end, tail);
+            bytes_.resize(begin + length + tail);
+            for (auto i = index; i < ends_.size(); ++i) {
+                ends_[i] = ends_[i] + begin + length - end;
+            }
+        }
+        if (length) {
+            std::memcpy(bytes_.data() + begin, value.data(), length);
+        }
+    }
+
+    //! \brief Reserve space for a number of bytes of string data.
+    void ReserveBytes(std::size_t sz) { bytes_.Reserve(sz); }
+
+    //! \brief The offset where each entry's string ends in the buffer. Entry i starts where entry i - 1 ends, and
+    //! entry 0 starts at zero.
+    const DFVector<std::uint64_t> &Ends() const { return ends_; }
+
+    //! \brief The bytes of all the strings.
+    const DFVector<char> &Bytes() const { return bytes_; }
+
+private:
+    //! \brief The offset where an entry's string starts in the buffer.
+    std::uint64_t Begin(std::size_t index) const { return index ? ends_[index - 1] : 0; }
+
+    //! \brief The offset where each entry's string ends.
+    DFVector<std::uint64_t> ends_;
+
+    //! \brief The bytes of all the strings.
+    DFVector<char> bytes_;
+};
+
+//! \brief The distinct strings of a categorical column, each with a code. Codes are assigned in the order that the
+//! strings are first inserted, and strings are never removed, so a code keeps its meaning for as long as the dictionary
+//! exists. This lets several vectors share one dictionary.
+class CategoryDictionary {
+public:
+    CategoryDictionary() = default;
+
+    //! \brief Copy a dictionary. The index references the strings, so it is rebuilt for the copied strings.
+    CategoryDictionary(const CategoryDictionary &dictionary) : values_(dictionary.values_) {
+        codes_.reserve(values_.size());
+        for (std::uint32_t code = 0; code < values_.size(); ++code) {
+            codes_.emplace(values_[code], code);
+        }
+    }
+
+    CategoryDictionary &operator=(const CategoryDictionary &) = delete;
+
+    //! \brief Get the code of a string, adding the string if it is not already in the dictionary.
+    std::uint32_t Insert(std::string_view value) {
+        auto it = codes_.find(value);
+        if (it != codes_.end()) {
+            return it->second;
+        }
+        auto code = static_cast<std::uint32_t>(values_.size());
+        // A deque never moves its strings, so the index can reference them.
+        values_.emplace_back(value);
+        codes_.emplace(values_.back(), code);
+        return code;
+    }
+
+    //! \brief Find the code of a string. Returns false if the string is not in the dictionary.
+    bool Find(std::string_view value, std::uint32_t &code) const {
+        auto it = codes_.find(value);
+        if (it == codes_.end()) {
+            return false;
+        }
+        code = it->second;
+        return true;
+    }
+
+    //! \brief The string with a code.
+    std::string_view operator[](std::uint32_t code) const { return values_[code]; }
+
+    //! \brief The number of strings in the dictionary.
+    std::size_t size() const { return values_.size(); }
+
+private:
+    //! \brief The strings, in the order of their codes.
+    std::deque<std::string> values_;
+
+    //! \brief The code of each string.
+    std::unordered_map<std::string_view, std::uint32_t> codes_;
+};
+
+//! \brief Specialization of DFVector for categorical data. Each entry is stored as a code into a dictionary of the
+//! distinct strings, and entries are read as string_views of the dictionary's strings. Copies of a vector share its
+//! dictionary, so copying, comparing, and appending vectors with the same dictionary only touch the codes. A shared
+//! dictionary is never changed, since the vectors sharing it may be read on other threads. A vector copies it before
+//! adding a string to it.
+template<>
+class DFVector<Categorical> {
+public:
+    // ========================================
+    //  Typedefs
+    // ========================================
+
+    using value_type = Categorical;
+    using self_type = DFVector<Categorical>;
+
+    //! \brief A reference to an entry, which reads as a string_view and can be assigned any string.
+    class CategoryReference {
+    public:
+        CategoryReference(self_type *vector, std::size_t index) : vector_(vector), index_(index) {}
+
+        CategoryReference &operator=(std::string_view value) {
+            vector_->codes_[index_] = vector_->Insert(value);
+            return *this;
+        }
+
+        CategoryReference &operator=(const CategoryReference &rhs) {
+            return *this = static_cast<std::string_view>(rhs);
+        }
+
+        operator std::string_view() const { return std::as_const(*vector_)[index_]; }
+
+        friend bool operator==(const CategoryReference &lhs, const CategoryReference &rhs) {
+            return std::string_view(lhs) == std::string_view(rhs);
+        }
+
+        friend bool operator==(const CategoryReference &lhs, std::string_view rhs) {
+            return std::string_view(lhs) == rhs;
+        }
+
+        friend bool operator==(std::string_view lhs, const CategoryReference &rhs) {
+            return lhs == std::string_view(rhs);
+        }
+
+        friend bool operator!=(const CategoryReference &lhs, std::string_view rhs) {
+            return std::string_view(lhs) != rhs;
+        }
+
+        friend std::ostream &operator<<(std::ostream &out, const CategoryReference &ref) {
+            return out << std::string_view(ref);
+        }
+
+    private:
+        self_type *vector_;
+        std::size_t index_;
+    };
+
+    using reference = CategoryReference;
+    using const_reference = std::string_view;
+
+    // ========================================
+    //  Constructors.
+    // ========================================
+
+    DFVector() = default;
+
+    explicit DFVector(std::size_t sz) { resize(sz); }
+
+    DFVector(std::size_t sz, std::string_view value) : codes_(sz, Insert(value)) {}
+
+    // ========================================
+    //  Functions to allow DFVector to operate like a std::vector when we need it to.
+    // ========================================
+
+    std::size_t size() const { return codes_.size(); }
+
+    bool empty() const { return codes_.empty(); }
+
+    std::string_view operator[](std::size_t index) const { return (*dictionary_)[codes_[index]]; }
+
+    CategoryReference operator[](std::size_t index) { return {this, index}; }
+
+    bool operator==(const self_type &rhs) const {
+        if (dictionary_ == rhs.dictionary_) {
+            return codes_ == rhs.codes_;
+        }
+        if (size() != rhs.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < size(); ++i) {
+            if ((*this)[i] != rhs[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void push_back(std::string_view value) { codes_.push_back(Insert(value)); }
+
+    void append(const self_type &rhs) {
+        if (dictionary_ == rhs.dictionary_) {
+            codes_.append(rhs.codes_);
+            return;
+        }
+        // Translate the other vector's codes into codes of this vector's dictionary, once per distinct string.
+        std::vector<std::uint32_t> translation(rhs.dictionary_->size());
+        for (std::uint32_t code = 0; code < translation.size(); ++code) {
+            translation[code] = Insert((*rhs.dictionary_)[code]);
+        }
+        codes_.Reserve(codes_.size() + rhs.codes_.size());
+        for (auto code : rhs.codes_) {
+            codes_.push_back(translation[code]);
+        }
+    }
+
+    void resize(std::size_t sz) {
+        if (sz < size()) {
+            codes_.resize(sz);
+            return;
+        }
+        // New entries are empty strings.
+        auto code = Insert("");
+        codes_.Reserve(sz);
+        while (size() < sz) {
+            codes_.push_back(code);
+        }
+    }
+
+    void Reserve(std::size_t sz) { codes_.Reserve(sz); }
+
+    // ========================================
+    //  Categorical specific functions.
+    // ========================================
+
+    //! \brief Add a string to the dictionary, if it is not already there, and return its code.
+    std::uint32_t AddCategory(std::string_view value) { return Insert(value); }
+
+    //! \brief Add an entry by its code, which must be a code from the dictionary.
+    void PushCode(std::uint32_t code) { codes_.push_back(code); }
+
+    //! \brief The code of each entry.
+    const DFVector<std::uint32_t> &Codes() const { return codes_; }
+
+    //! \brief The dictionary of the strings.
+    const CategoryDictionary &Dictionary() const { return *dictionary_; }
+
+private:
+    //! \brief Get the code of a string, adding the string to the dictionary if it is not already there. If other
+    //! vectors share the dictionary, the string is added to a copy of it.
+    std::uint32_t Insert(std::string_view value) {
+        std::uint32_t code;
+        if (dictionary_->Find(value, code)) {
+            return code;
+        }
+        if (dictionary_.use_count() > 1) {
+            dictionary_ = std::make_shared<CategoryDictionary>(*dictionary_);
+        }
+        return dictionary_->Insert(value);
+    }
+
+    //! \brief The dictionary of the distinct strings.
+    std::shared_ptr<CategoryDictionary> dictionary_ = std::make_shared<CategoryDictionary>();
+
+    //! \brief The code of each entry.
+    DFVector<std::uint32_t> codes_;
+};
+
+//! \brief The entries of a DFVector, in the form that is fastest for a kernel to read: a plain pointer to the entries,
+//! or, for vectors that do not store their entries as objects, the vector itself.
+template<typename T>
+const T *Entries(const DFVector<T> &data) {
+    return data.data();
+}
+
+inline const DFVector<std::string> &Entries(const DFVector<std::string> &data) {
+    return data;
+}
+
+inline const DFVector<Categorical> &Entries(const DFVector<Categorical> &data) {
+    return data;
+}
+
 }
 #endif // __DF_VECTOR_H__
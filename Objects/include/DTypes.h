@@ -2,10 +2,18 @@
 #define __DTYPES_H__
 
 #include <string>
+#include <cstdint>
+#include <string_view>
 #include <ostream>
+#include <sstream>
 #include <cmath>
+#include <cstdio>
+#include <limits>
+#include <charconv>
+#include <type_traits>
 
 #include "Utility.h"
+#include "Timestamp.h"
 
 namespace dataframe {
 
@@ -14,12 +22,32 @@ namespace dataframe {
     // ========================================
 
     //! \brief The possible DTypes. None represents a column of size zero. Empty is a column of non-zero size with only
-    //! NaN values. Integer, Float, Double, Bool, and String represent the obvious data types. Other is any other type of
-    //! data.
+    //! NaN values. Integer, Float, Double, Bool, and String represent the obvious data types. Categorical is strings
+    //! stored as codes into a dictionary of their distinct values. Timestamp is a point in time, stored as seconds since
+    //! the epoch. Int8, Int16, Int64, and UInt8 through UInt64 are integers of other widths than Integer, which is a
+    //! 32 bit int. Other is any other type of data.
     enum class DType {
-        None, Other, Empty, Integer, Float, Double, Bool, String
+        None, Other, Empty, Integer, Float, Double, Bool, String, Categorical, Timestamp,
+        Int8, Int16, Int64, UInt8, UInt16, UInt32, UInt64
     };
 
+    //! \brief Whether a dtype is one of the integer dtypes, of any width.
+    inline bool IsIntegerDType(DType dtype) {
+        switch (dtype) {
+            case DType::Integer:
+            case DType::Int8:
+            case DType::Int16:
+            case DType::Int64:
+            case DType::UInt8:
+            case DType::UInt16:
+            case DType::UInt32:
+            case DType::UInt64:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     // ========================================
     //  Tag types.
     // ========================================
@@ -42,6 +70,24 @@ namespace dataframe {
         bool operator<=(const EmptyDType &) const { return true; }
     };
 
+    //! \brief The type of the entries of a categorical column. A categorical column stores each entry as a small
+    //! integer code into a dictionary of the column's distinct strings, so a Categorical is only a view of one of those
+    //! strings.
+    struct Categorical {
+        Categorical() = default;
+
+        Categorical(std::string_view value) : value(value) {}
+
+        operator std::string_view() const { return value; }
+
+        bool operator==(const Categorical &rhs) const { return value == rhs.value; }
+
+        bool operator<(const Categorical &rhs) const { return value < rhs.value; }
+
+        //! \brief The string.
+        std::string_view value;
+    };
+
     // ========================================
     //  Stream operator.
     // ========================================
@@ -72,6 +118,33 @@ namespace dataframe {
             case DType::String:
                 out << "DType::String";
                 break;
+            case DType::Categorical:
+                out << "DType::Categorical";
+                break;
+            case DType::Timestamp:
+                out << "DType::Timestamp";
+                break;
+            case DType::Int8:
+                out << "DType::Int8";
+                break;
+            case DType::Int16:
+                out << "DType::Int16";
+                break;
+            case DType::Int64:
+                out << "DType::Int64";
+                break;
+            case DType::UInt8:
+                out << "DType::UInt8";
+                break;
+            case DType::UInt16:
+                out << "DType::UInt16";
+                break;
+            case DType::UInt32:
+                out << "DType::UInt32";
+                break;
+            case DType::UInt64:
+                out << "DType::UInt64";
+                break;
         }
         return out;
     }
@@ -120,6 +193,51 @@ namespace dataframe {
         static const DType dtype = DType::String;
     };
 
+    template<>
+    struct DTypeOf<Categorical> {
+        static const DType dtype = DType::Categorical;
+    };
+
+    template<>
+    struct DTypeOf<Timestamp> {
+        static const DType dtype = DType::Timestamp;
+    };
+
+    template<>
+    struct DTypeOf<std::int8_t> {
+        static const DType dtype = DType::Int8;
+    };
+
+    template<>
+    struct DTypeOf<std::int16_t> {
+        static const DType dtype = DType::Int16;
+    };
+
+    template<>
+    struct DTypeOf<std::int64_t> {
+        static const DType dtype = DType::Int64;
+    };
+
+    template<>
+    struct DTypeOf<std::uint8_t> {
+        static const DType dtype = DType::UInt8;
+    };
+
+    template<>
+    struct DTypeOf<std::uint16_t> {
+        static const DType dtype = DType::UInt16;
+    };
+
+    template<>
+    struct DTypeOf<std::uint32_t> {
+        static const DType dtype = DType::UInt32;
+    };
+
+    template<>
+    struct DTypeOf<std::uint64_t> {
+        static const DType dtype = DType::UInt64;
+    };
+
     // ========================================
     //  Convert DTypes to types
     // ========================================
@@ -159,6 +277,51 @@ namespace dataframe {
         using type = std::string;
     };
 
+    template<>
+    struct TypeOfDType<DType::Categorical> {
+        using type = Categorical;
+    };
+
+    template<>
+    struct TypeOfDType<DType::Timestamp> {
+        using type = Timestamp;
+    };
+
+    template<>
+    struct TypeOfDType<DType::Int8> {
+        using type = std::int8_t;
+    };
+
+    template<>
+    struct TypeOfDType<DType::Int16> {
+        using type = std::int16_t;
+    };
+
+    template<>
+    struct TypeOfDType<DType::Int64> {
+        using type = std::int64_t;
+    };
+
+    template<>
+    struct TypeOfDType<DType::UInt8> {
+        using type = std::uint8_t;
+    };
+
+    template<>
+    struct TypeOfDType<DType::UInt16> {
+        using type = std::uint16_t;
+    };
+
+    template<>
+    struct TypeOfDType<DType::UInt32> {
+        using type = std::uint32_t;
+    };
+
+    template<>
+    struct TypeOfDType<DType::UInt64> {
+        using type = std::uint64_t;
+    };
+
     // ========================================
     //  Define storage types.
     // ========================================
@@ -226,7 +389,14 @@ namespace dataframe {
 
     template<>
     struct IsNaN<std::string> {
-        static bool check(const std::string &v) {
+        static bool check(std::string_view v) {
+            return v.empty();
+        }
+    };
+
+    template<>
+    struct IsNaN<Categorical> {
+        static bool check(std::string_view v) {
             return v.empty();
         }
     };
@@ -238,6 +408,24 @@ namespace dataframe {
         }
     };
 
+    //! \brief The value stored in the data of a column where an entry is null. Whether an entry is null is recorded in
+    //! the column's validity bitmap, so this is only a filler, but floating point types use NaN so that code that reads
+    //! the raw data still sees something that is not a number.
+    template<typename value_type>
+    struct NullValue {
+        static value_type value() { return value_type(); }
+    };
+
+    template<>
+    struct NullValue<double> {
+        static double value() { return std::numeric_limits<double>::quiet_NaN(); }
+    };
+
+    template<>
+    struct NullValue<float> {
+        static float value() { return std::numeric_limits<float>::quiet_NaN(); }
+    };
+
 
     // ========================================
     //  Some basic formatting.
@@ -274,6 +462,44 @@ namespace dataframe {
         static void ToStream(const EmptyDType &v, std::ostream &out) {}
     };
 
+    template<>
+    struct Format<std::string> {
+        static void ToStream(std::string_view v, std::ostream &out) {
+            out << v;
+        }
+    };
+
+    template<>
+    struct Format<Categorical> {
+        static void ToStream(std::string_view v, std::ostream &out) {
+            out << v;
+        }
+    };
+
+    //! \brief Eight bit integers would be written as characters by a stream.
+    template<>
+    struct Format<std::int8_t> {
+        static void ToStream(const std::int8_t &v, std::ostream &out) {
+            out << static_cast<int>(v);
+        }
+    };
+
+    template<>
+    struct Format<std::uint8_t> {
+        static void ToStream(const std::uint8_t &v, std::ostream &out) {
+            out << static_cast<int>(v);
+        }
+    };
+
+    template<>
+    struct Format<Timestamp> {
+        static void ToStream(const Timestamp &v, std::ostream &out) {
+            std::string text;
+            AppendTimestamp(v, text);
+            out << text;
+        }
+    };
+
     template<>
     struct Format<bool> {
         static void ToStream(const bool &v, std::ostream &out) {
@@ -287,5 +513,125 @@ namespace dataframe {
         }
     };
 
+    // ========================================
+    //  Formatting into text buffers.
+    // ========================================
+
+    namespace detail {
+        //! \brief Append a field to a csv buffer, quoting it if it would not be read back as the same text: if it
+        //! contains the delimiter, a quote, or a line break, or starts or ends with whitespace. Quotes are doubled.
+        //! If the quote character is '\0', the field is appended as is.
+        inline void AppendField(std::string_view v, std::string &out, char delimiter, char quote) {
+            bool needs_quotes = false;
+            if (quote != '\0' && !v.empty()) {
+                needs_quotes = isspace(v.front()) || isspace(v.back());
+                for (std::size_t i = 0; i < v.size() && !needs_quotes; ++i) {
+                    needs_quotes = v[i] == delimiter || v[i] == quote || v[i] == '\n' || v[i] == '\r';
+                }
+            }
+            if (!needs_quotes) {
+                out += v;
+                return;
+            }
+            out += quote;
+            for (char c : v) {
+                if (c == quote) {
+                    out += quote;
+                }
+                out += c;
+            }
+            out += quote;
+        }
+
+        //! \brief Append an integer or floating point number to a buffer, without going through a stream. Floating
+        //! point numbers are written with the shortest text that reads back as exactly the same number.
+        template<typename value_type>
+        inline void AppendNumber(const value_type &v, std::string &out) {
+            char buffer[64];
+#if defined(__cpp_lib_to_chars)
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+            out.append(buffer, result.ptr);
+#else
+            if constexpr (std::is_integral<value_type>::value) {
+                auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+                out.append(buffer, result.ptr);
+            }
+            else {
+                // Without floating point to_chars, fall back on enough digits to round trip.
+                auto size = std::snprintf(buffer, sizeof(buffer), "%.17g", static_cast<double>(v));
+                out.append(buffer, static_cast<std::size_t>(size));
+            }
+#endif
+        }
+
+        template<bool is_number, typename value_type>
+        struct TextCheck {
+            static void Append(const value_type &v, std::string &out, char, char) {
+                AppendNumber(v, out);
+            }
+        };
+
+        template<typename value_type>
+        struct TextCheck<false, value_type> {
+            static void Append(const value_type &v, std::string &out, char delimiter, char quote) {
+                std::ostringstream stream;
+                Format<value_type>::ToStream(v, stream);
+                AppendField(stream.str(), out, delimiter, quote);
+            }
+        };
+    }
+
+    //! \brief Appends values to a text buffer as csv fields. Numbers are formatted directly into the buffer, and
+    //! anything else is formatted the same way Format writes it to a stream, and quoted if necessary.
+    template<typename value_type>
+    struct TextFormat {
+        static void Append(const value_type &v, std::string &out, char delimiter, char quote) {
+            detail::TextCheck<std::is_arithmetic<value_type>::value && !std::is_same<value_type, char>::value,
+                    value_type>::Append(v, out, delimiter, quote);
+        }
+    };
+
+    template<>
+    struct TextFormat<NoneDType> {
+        static void Append(const NoneDType &v, std::string &out, char delimiter, char quote) {}
+    };
+
+    template<>
+    struct TextFormat<EmptyDType> {
+        static void Append(const EmptyDType &v, std::string &out, char delimiter, char quote) {}
+    };
+
+    template<>
+    struct TextFormat<bool> {
+        static void Append(const bool &v, std::string &out, char delimiter, char quote) {
+            if (v == 0) {
+                out += "FALSE";
+            } else if (v == 1) {
+                out += "TRUE";
+            }
+        }
+    };
+
+    template<>
+    struct TextFormat<std::string> {
+        static void Append(std::string_view v, std::string &out, char delimiter, char quote) {
+            detail::AppendField(v, out, delimiter, quote);
+        }
+    };
+
+    template<>
+    struct TextFormat<Categorical> {
+        static void Append(std::string_view v, std::string &out, char delimiter, char quote) {
+            detail::AppendField(v, out, delimiter, quote);
+        }
+    };
+
+    template<>
+    struct TextFormat<Timestamp> {
+        static void Append(const Timestamp &v, std::string &out, char delimiter, char quote) {
+            AppendTimestamp(v, out);
+        }
+    };
+
 }
 #endif // __DTYPES_H__
\ No newline at end of file
@@ -9,15 +9,17 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <string_view>
 
 #include "DTypes.h"
+#include "CSVOptions.h"
+#include "IndexMap.h"
+#include "Indicator.h"
 
 namespace dataframe {
 
-    //! \brief Indicators (i.e. vectors of bools) can be returned from column comparison and used to select
-    //! new views of DataFrames.
-    using Indicator = std::vector<bool>;
-
+    class CSVBatchReader;
 
     class DataFrame {
     public:
@@ -35,6 +37,23 @@ namespace dataframe {
         //! \brief Creates an empty DataFrame.
         DataFrame() = default;
 
+        //! \brief Copy a DataFrame. The copy refers to the same columns, and gets its own index of them.
+        DataFrame(const DataFrame &df) : data_(df.data_) {
+            IndexColumns();
+        }
+
+        DataFrame(DataFrame &&df) = default;
+
+        DataFrame &operator=(const DataFrame &df) {
+            if (this != &df) {
+                data_ = df.data_;
+                IndexColumns();
+            }
+            return *this;
+        }
+
+        DataFrame &operator=(DataFrame &&df) = default;
+
         // ========================================
         //  Accessors.
         // ========================================
@@ -61,11 +80,15 @@ namespace dataframe {
         //! \brief Returns whether the DataFrame has no columns.
         bool Empty() const;
 
+        //! \brief Returns the names and dtypes of the columns, in order. A schema can be reused to read other csvs
+        //! with the same layout.
+        Schema GetSchema() const;
+
         // ========================================
         //  Selection
         // ========================================
 
-        //! \brief Access a column of the DataFrame.
+        //! \brief Access a column of the DataFrame, by name, adding the column if there is no column with that name.
         Column &operator[](const std::string &name);
 
         //! \brief Create a reference DataFrame that is a selected subset of the DataFrame.
@@ -74,7 +97,9 @@ namespace dataframe {
         //! \brief Explicitly create a reference copy of the DataFrame.
         DataFrame Ref() const;
 
-        //! \brief Create a copy by value_ of the DataFrame.
+        //! \brief Create a copy by value_ of the DataFrame. The columns of the copy share their data with the columns of
+        //! this DataFrame until either one is written to, so cloning only costs as much as copying the data of the
+        //! columns that are actually modified.
         DataFrame Clone() const;
 
         // ========================================
@@ -96,6 +121,9 @@ namespace dataframe {
         template<typename ...Args>
         bool Append(const Args &... args);
 
+        //! \brief Coalesce the chunks that appending linked onto each column, so every column is stored contiguously.
+        void Compact();
+
         // ========================================
         //  Column manipulation - Rearranging, renaming, erasing, etc.
         // ========================================
@@ -116,6 +144,15 @@ namespace dataframe {
         //! \brief Drop any none columns. Returns the number of columns that were dropped.
         std::size_t DropNones();
 
+        // ========================================
+        //  Statistics.
+        // ========================================
+
+        //! \brief Summarize the numeric columns of the DataFrame. The result has a "statistic" column naming each row
+        //! (count, mean, std, min, max, sum), and a column of doubles for each numeric column, whose statistics are
+        //! found in a single pass over the column. Null entries, and NaNs, are skipped.
+        DataFrame Describe() const;
+
         // ========================================
         //  Reading and writing.
         // ========================================
@@ -123,15 +160,52 @@ namespace dataframe {
         //! \brief Create a DataFrame from an istream.
         static DataFrame FromStream(std::istream &in);
 
+        //! \brief Create a DataFrame from an istream, using the specified options. If more than one thread is
+        //! requested, the body of the stream is split into row-aligned chunks, each chunk is parsed on its own
+        //! thread, and the chunks' columns are spliced together in order.
+        static DataFrame FromStream(std::istream &in, const CSVOptions &options);
+
         //! \brief Read a DataFrame from a csv.
         static DataFrame ReadCSV(const std::string &filename);
 
+        //! \brief Read a DataFrame from a csv, using the specified options.
+        static DataFrame ReadCSV(const std::string &filename, const CSVOptions &options);
+
+        //! \brief Infer the schema of a csv by sampling its rows, the same way that ReadCSV does when the options
+        //! request sampled dtypes. Columns that only had empty fields in the sample have DType::None.
+        static Schema InferSchema(const std::string &filename, const CSVOptions &options = CSVOptions());
+
         //! \brief Write a representation of the DataFrame to an ostream.
         bool ToStream(std::ostream &out);
 
+        //! \brief Write the DataFrame to an ostream as a csv, using the specified options. Blocks of rows are
+        //! formatted into a buffer a column at a time, and the buffer is written all at once. If more than one thread
+        //! is requested, several blocks are formatted in parallel and written in order.
+        bool ToStream(std::ostream &out, const CSVOptions &options);
+
         //! \brief Write the DataFrame to a file as a csv.
         bool ToCSV(const std::string &filename);
 
+        //! \brief Write the DataFrame to a file as a csv, using the specified options.
+        bool ToCSV(const std::string &filename, const CSVOptions &options);
+
+        //! \brief Save the DataFrame to a file in a binary, columnar format that can be loaded without any parsing.
+        //! Returns false if the file could not be written, or if a column's type has no binary format (only
+        //! DTypes other than DType::Other can be saved).
+        bool Save(const std::string &filename) const;
+
+        //! \brief Load a DataFrame that was saved with Save. The file is memory mapped. Columns of numbers and
+        //! timestamps use their data in place in the mapping, which stays mapped as long as any of them do, and are only
+        //! copied if they are modified. The data of other columns is copied out of the mapping. Returns an empty
+        //! DataFrame if the file could not be opened, and throws if it is not a valid DataFrame file.
+        static DataFrame Load(const std::string &filename);
+
+        // ========================================
+        //  Friend classes.
+        // ========================================
+
+        friend class CSVBatchReader;
+
     private:
         // ========================================
         //  Typedefs.
@@ -139,7 +213,30 @@ namespace dataframe {
 
         using ColPair = std::pair<std::string, Column>;
         using StorageType = std::list<ColPair>;
-        using IMapType = std::shared_ptr<std::vector<std::size_t>>;
+
+        //! \brief What to do with the fields of each row of a csv. This is decided once, before any rows are parsed.
+        struct ParsePlan {
+            //! \brief For each field of a row, the index of the column it is stored in, or -1 if it is not read.
+            std::vector<long> columns;
+
+            //! \brief For each column, whether it is parsed directly into a known dtype, without inference.
+            std::vector<bool> fixed;
+
+            //! \brief For each column, the format its timestamps are read with. Empty for columns without a format.
+            std::vector<TimestampFormat> timestamp_formats;
+
+            //! \brief The index of the field that each row filter tests, and the filter.
+            std::vector<std::pair<std::size_t, const RowFilter*>> filters;
+
+            //! \brief The number of fields at the start of each row that have to be looked at.
+            std::size_t num_fields = 0;
+
+            //! \brief The character that separates fields.
+            char delimiter = ',';
+
+            //! \brief The character that quotes fields, or '\0' if fields are not quoted.
+            char quote = '"';
+        };
 
         // ========================================
         //  Private constructors.
@@ -147,17 +244,24 @@ namespace dataframe {
 
         //! \brief Private constructor, constructs a data frame from the list of column pairs.
         explicit DataFrame(StorageType &&data)
-                : data_(std::move(data)) {}
+                : data_(std::move(data)) {
+            IndexColumns();
+        }
 
         // ========================================
         //  Private helper functions.
         // ========================================
 
-        //! \brief Convenience method to create a new index map.
-        static IMapType MakeIndexMap();
-
         void AddEntriesToIndexMap(std::size_t num_entries = 1);
 
+        //! \brief Rebuild the index of the columns from data_. This must be done whenever columns are reordered, or
+        //! added or removed other than through operator[], Rename, or DropColumn, which update their own entries.
+        void IndexColumns();
+
+        //! \brief Remove a column, which must be the one its name is indexed to, from the index of the columns. If
+        //! another column has the same name, the name is indexed to that column instead.
+        void UnindexColumn(StorageType::iterator it);
+
         //! \brief Get an iterator to a column, by name. Returns data_.end() if column does not exist.
         StorageType::iterator GetColumn(const std::string &name);
 
@@ -168,6 +272,78 @@ namespace dataframe {
         //! stripped off. Used on column names when reading CSVs.
         static std::string TrimWhiteSpaceToFit(const std::string &name);
 
+        //! \brief Split the header row of a csv into column names, using the delimiter and quote character from the
+        //! options. Unnamed columns are given names.
+        static std::vector<std::string> ReadColumnNames(const std::string &header, const CSVOptions &options);
+
+        //! \brief Create storage for a csv with the specified column names. All columns start out as DType::None.
+        static StorageType MakeStorage(const std::vector<std::string> &names);
+
+        //! \brief Create storage for a csv with the specified column names and initial dtypes.
+        static StorageType MakeStorage(const std::vector<std::string> &names, const std::vector<DType> &dtypes);
+
+        //! \brief If the options contain a full schema, replace the column names from a csv's header with the names
+        //! in the schema.
+        static void ApplySchemaNames(std::vector<std::string> &names, const CSVOptions &options);
+
+        //! \brief Decide how the fields of a csv with the specified column names are read. The names and dtypes of
+        //! the columns that will be stored are appended to column_names and dtypes. Fields that are not given dtypes
+        //! by the options start out with the corresponding field_dtypes.
+        static ParsePlan MakePlan(const std::vector<std::string> &names, const std::vector<DType> &field_dtypes,
+                                  const CSVOptions &options, std::vector<std::string> &column_names,
+                                  std::vector<DType> &dtypes);
+
+        //! \brief If storage has columns with exactly the specified names and dtypes, and nothing else references
+        //! their data, empty the columns (keeping their memory) so they can be filled again, and return true.
+        static bool RecycleStorage(StorageType &storage, const std::vector<std::string> &names,
+                                   const std::vector<DType> &dtypes);
+
+        //! \brief Decide the dtypes of the columns of the csv rows in [begin, end) by sampling rows from the head of
+        //! the data, and short runs of rows spaced evenly through the data. Columns whose sampled fields were all
+        //! empty are DType::None.
+        static std::vector<DType> SampleDTypes(const char *begin, const char *end, std::size_t num_columns,
+                                               const CSVOptions &options);
+
+        //! \brief Add a (tokenized) field read from a csv to a column, changing the column's type if the field
+        //! cannot be represented by the column's current type. The dtype is the dtype inferred for the column so far.
+        static void AddField(Column &column, DType &dtype, std::string_view data);
+
+        //! \brief Parse the newline separated csv rows in [begin, end) into storage for columns with the specified
+        //! names. If the options request more than one thread, the rows are split into row-aligned chunks that
+        //! are parsed in parallel. If the options contain a schema, its names replace the specified names.
+        static StorageType ParseChunked(const char *begin, const char *end, std::vector<std::string> names,
+                                        const CSVOptions &options);
+
+        //! \brief Parse the newline separated csv rows in [begin, end) into the columns of storage, as described by
+        //! the plan. Fixed columns are parsed directly into their current dtypes, and the dtypes of the other columns
+        //! are inferred.
+        static void ParseRows(const char *begin, const char *end, StorageType &storage, std::vector<DType> &dtypes,
+                              const ParsePlan &plan);
+
+        //! \brief Whether the options give the dtype of a column, so it must not be inferred or changed.
+        static bool HasGivenDType(const std::string &name, const CSVOptions &options);
+
+        //! \brief If the options ask for it, convert the inferred integer columns of storage to the narrowest integer
+        //! dtypes that hold all of their values.
+        static void NarrowIntegers(StorageType &storage, const CSVOptions &options);
+
+        //! \brief Convert the string columns of storage that have few enough distinct values, as decided by the
+        //! options, to categorical columns. Columns given dtypes by the options, or whose entry in fixed is true, are
+        //! not converted.
+        static void DetectCategoricals(StorageType &storage, const CSVOptions &options,
+                                       const std::vector<bool> &fixed = {});
+
+        //! \brief Format the rows [first, last) as csv rows. The text replaces the contents of buffer.
+        void FormatRows(std::size_t first, std::size_t last, const CSVOptions &options, std::string &buffer) const;
+
+        //! \brief Append the columns of a chunk of a csv onto the columns of storage. Columns whose dtypes differ
+        //! are first converted to their common dtype.
+        static void MergeChunk(StorageType &storage, StorageType &chunk);
+
+        //! \brief Release the text that the columns of storage kept while their dtypes were inferred, once the dtypes
+        //! are final.
+        static void ReleaseSourceText(StorageType &storage);
+
         template<typename ...Args, std::size_t ...Seq>
         bool HelpAppend(std::index_sequence<Seq...>, const Args &...args) {
             auto tuples = std::make_tuple(std::next(data_.begin(), Seq)...);
@@ -194,6 +370,11 @@ namespace dataframe {
 
         //! \brief The dataframe's actual data.
         StorageType data_;
+
+        //! \brief Each column in data_, by name, so columns are found without scanning data_. The nodes of a list never
+        //! move, so adding a column leaves references to the other columns valid. If several columns have the same
+        //! name, this is the first of them.
+        std::unordered_map<std::string, StorageType::iterator> column_index_;
     };
 
 
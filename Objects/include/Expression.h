@@ -0,0 +1,618 @@
+//
+// Created by Nathaniel Rupprecht on 6/8/21.
+//
+
+#ifndef __EXPRESSION_H__
+#define __EXPRESSION_H__
+
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Column.h"
+#include "CompareKernels.h"
+
+namespace dataframe {
+
+    //! \brief The number of rows that an expression is evaluated for at a time. Every node of an expression that needs
+    //! scratch space holds one block, so the whole expression works in cache. This is a multiple of 64, so every block
+    //! fills whole words of an indicator.
+    constexpr std::size_t kExpressionBlockSize = 4096;
+
+    namespace detail {
+        //! \brief The size of an expression that has no rows of its own, like a number.
+        constexpr std::size_t kAnySize = static_cast<std::size_t>(-1);
+
+        //! \brief The size of an expression whose columns have different numbers of rows.
+        constexpr std::size_t kMismatchedSize = static_cast<std::size_t>(-2);
+
+        //! \brief The number of rows of an expression with two operands.
+        inline std::size_t CombineSizes(std::size_t lhs, std::size_t rhs) {
+            if (lhs == kAnySize) {
+                return rhs;
+            }
+            if (rhs == kAnySize) {
+                return lhs;
+            }
+            return lhs == rhs ? lhs : kMismatchedSize;
+        }
+
+        //! \brief Make sure a scratch buffer has room for size entries, and return its data.
+        template<typename T>
+        T *Scratch(std::vector<T> &buffer, std::size_t size) {
+            if (buffer.size() < size) {
+                buffer.resize(size);
+            }
+            return buffer.data();
+        }
+
+        //! \brief Set the first count bits of the words, and clear the rest of the last word.
+        inline void SetBits(std::size_t count, std::uint64_t *words) {
+            const auto num_words = Indicator::WordsFor(count);
+            std::fill(words, words + num_words, ~std::uint64_t(0));
+            if (count & 63) {
+                words[num_words - 1] = (std::uint64_t(1) << (count & 63)) - 1;
+            }
+        }
+
+        //! \brief And the words of a block of count rows with other words.
+        inline void AndBits(std::size_t count, std::uint64_t *words, const std::uint64_t *other) {
+            const auto num_words = Indicator::WordsFor(count);
+            for (std::size_t w = 0; w < num_words; ++w) {
+                words[w] &= other[w];
+            }
+        }
+
+        //! \brief The comparison that has the same result when its operands are swapped.
+        inline CompareOp Mirror(CompareOp op) {
+            switch (op) {
+                case CompareOp::Lt:
+                    return CompareOp::Gt;
+                case CompareOp::Gt:
+                    return CompareOp::Lt;
+                case CompareOp::Le:
+                    return CompareOp::Ge;
+                case CompareOp::Ge:
+                    return CompareOp::Le;
+                default:
+                    return op;
+            }
+        }
+
+        struct NumericTag : ExpressionTag {};
+        struct BooleanTag : ExpressionTag {};
+    }
+
+    // ========================================
+    //  Expressions.
+    // ========================================
+
+    //! \brief The base of expressions that have a number for every row. Arithmetic on columns and numbers builds an
+    //! expression instead of computing anything. When the expression is evaluated, it is evaluated a block of rows at a
+    //! time, all the way through the expression, so no intermediate result is ever stored for every row. Numbers are
+    //! evaluated as doubles. Every block also carries a validity mask, so a row is null if an entry of a column that it
+    //! is computed from is null.
+    //!
+    //! Every expression has the functions
+    //!     std::size_t Size() const - the number of rows.
+    //!     void EvaluateBlock(std::size_t first, std::size_t count, double* out, std::uint64_t* valid) const - write
+    //!         rows [first, first + count) into out, and which of them are valid into the words at valid (with any bits
+    //!         past count zero), where first is a multiple of kExpressionBlockSize and count is at most
+    //!         kExpressionBlockSize.
+    //!
+    //! Expressions keep scratch space for one block in their nodes, so one expression object should not be evaluated
+    //! on several threads at once.
+    template<typename Derived>
+    struct NumericExpression : detail::NumericTag {
+        //! \brief Evaluate the expression for every row. If valid is not null, it is set to which rows are valid (not
+        //! null).
+        std::vector<double> Evaluate(Indicator *valid = nullptr) const {
+            const auto &self = static_cast<const Derived &>(*this);
+            const auto size = self.Size();
+            if (size == detail::kAnySize || size == detail::kMismatchedSize) {
+                return {};
+            }
+            std::vector<double> output(size);
+            Indicator validity(size);
+            auto *words = validity.Words().data();
+            for (std::size_t first = 0; first < size; first += kExpressionBlockSize) {
+                self.EvaluateBlock(first, std::min(kExpressionBlockSize, size - first), output.data() + first,
+                                   words + first / 64);
+            }
+            if (valid) {
+                *valid = std::move(validity);
+            }
+            return output;
+        }
+    };
+
+    //! \brief The base of expressions that are true or false for every row, like comparisons of numeric expressions,
+    //! and logical combinations of them. These are evaluated like numeric expressions, except that EvaluateBlock writes
+    //! the words of an indicator (with any bits past count zero) instead of doubles and a validity mask. A comparison is
+    //! false for null rows, as comparisons of columns are.
+    template<typename Derived>
+    struct BooleanExpression : detail::BooleanTag {
+        //! \brief Evaluate the expression for every row. Returns an empty indicator if the columns in the expression
+        //! have different numbers of rows.
+        Indicator Evaluate() const {
+            const auto &self = static_cast<const Derived &>(*this);
+            const auto size = self.Size();
+            if (size == detail::kAnySize || size == detail::kMismatchedSize) {
+                return {};
+            }
+            Indicator output(size);
+            auto *words = output.Words().data();
+            for (std::size_t first = 0; first < size; first += kExpressionBlockSize) {
+                self.EvaluateBlock(first, std::min(kExpressionBlockSize, size - first), words + first / 64);
+            }
+            return output;
+        }
+
+        //! \brief The number of rows for which the expression is true. The rows are counted a block at a time, so no
+        //! indicator is made.
+        std::size_t Count() const {
+            const auto &self = static_cast<const Derived &>(*this);
+            const auto size = self.Size();
+            if (size == detail::kAnySize || size == detail::kMismatchedSize) {
+                return 0;
+            }
+            std::uint64_t words[kExpressionBlockSize / 64];
+            std::size_t count = 0;
+            for (std::size_t first = 0; first < size; first += kExpressionBlockSize) {
+                const auto block = std::min(kExpressionBlockSize, size - first);
+                self.EvaluateBlock(first, block, words);
+                for (std::size_t w = 0; w < Indicator::WordsFor(block); ++w) {
+                    count += static_cast<std::size_t>(__builtin_popcountll(words[w]));
+                }
+            }
+            return count;
+        }
+
+        //! \brief A boolean expression can be used anywhere an indicator can, e.g. to select a view of a data frame.
+        operator Indicator() const {
+            return static_cast<const Derived &>(*this).Evaluate();
+        }
+    };
+
+    //! \brief A column, as an expression.
+    class ColumnExpression : public NumericExpression<ColumnExpression> {
+    public:
+        explicit ColumnExpression(const DataFrame::Column &column) : column_(column) {}
+
+        std::size_t Size() const { return column_.Size(); }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, double *out, std::uint64_t *valid) const {
+            column_.ReadDoubles(first, count, out);
+            column_.ReadValidity(first, count, valid);
+        }
+
+    private:
+        //! \brief The column. Copies of a column refer to the same data, so the expression keeps the data alive.
+        DataFrame::Column column_;
+    };
+
+    //! \brief A number, as an expression.
+    class ScalarExpression : public NumericExpression<ScalarExpression> {
+    public:
+        explicit ScalarExpression(double value) : value_(value) {}
+
+        std::size_t Size() const { return detail::kAnySize; }
+
+        void EvaluateBlock(std::size_t, std::size_t count, double *out, std::uint64_t *valid) const {
+            std::fill(out, out + count, value_);
+            detail::SetBits(count, valid);
+        }
+
+        double Value() const { return value_; }
+
+    private:
+        double value_;
+    };
+
+    //! \brief An indicator, as an expression.
+    class IndicatorExpression : public BooleanExpression<IndicatorExpression> {
+    public:
+        explicit IndicatorExpression(Indicator indicator) : indicator_(std::move(indicator)) {}
+
+        std::size_t Size() const { return indicator_.size(); }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, std::uint64_t *out) const {
+            const auto *words = indicator_.Words().data() + first / 64;
+            std::copy(words, words + Indicator::WordsFor(count), out);
+        }
+
+    private:
+        Indicator indicator_;
+    };
+
+    //! \brief A comparison of a column with a value, of type Value, like df["More"] >= 15. Comparing a column with a
+    //! value makes one of these. Used on its own, e.g. to select a view, it is evaluated for the whole column at once,
+    //! with the comparison kernels for the column's type, as an indicator. Combined with other boolean expressions, it
+    //! is evaluated a block at a time along with them, so (15. <= df["More"]) & (df["Basic"] < 5) makes one indicator
+    //! instead of three.
+    template<typename Value>
+    class ScalarComparison : public BooleanExpression<ScalarComparison<Value>> {
+    public:
+        ScalarComparison(CompareOp op, const DataFrame::Column &column, Value value)
+                : op_(op), column_(column), value_(std::move(value)) {}
+
+        std::size_t Size() const { return column_.Size(); }
+
+        //! \brief Compare the whole column with the value. Returns an empty indicator if the column cannot be
+        //! compared with the value.
+        Indicator Evaluate() const {
+            return column_.Compare(op_, value_, 0, column_.Size());
+        }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, std::uint64_t *out) const {
+            const auto block = column_.Compare(op_, value_, first, count);
+            if (block.size() != count) {
+                std::fill(out, out + Indicator::WordsFor(count), 0);
+                return;
+            }
+            std::copy(block.Words().begin(), block.Words().end(), out);
+        }
+
+    private:
+        CompareOp op_;
+
+        //! \brief The column. Copies of a column refer to the same data, so the expression keeps the data alive.
+        DataFrame::Column column_;
+
+        Value value_;
+    };
+
+    //! \brief Arithmetic on two numeric expressions. Op is a function object, like std::plus<>. Numbers are applied
+    //! to each row directly, without filling a block with them. A row is valid if it is valid in both operands.
+    template<typename Op, typename L, typename R>
+    class ArithmeticExpression : public NumericExpression<ArithmeticExpression<Op, L, R>> {
+    public:
+        ArithmeticExpression(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+
+        std::size_t Size() const { return detail::CombineSizes(lhs_.Size(), rhs_.Size()); }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, double *out, std::uint64_t *valid) const {
+            Op op;
+            if constexpr (std::is_same<R, ScalarExpression>::value) {
+                lhs_.EvaluateBlock(first, count, out, valid);
+                const auto value = rhs_.Value();
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[i] = op(out[i], value);
+                }
+            }
+            else if constexpr (std::is_same<L, ScalarExpression>::value) {
+                rhs_.EvaluateBlock(first, count, out, valid);
+                const auto value = lhs_.Value();
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[i] = op(value, out[i]);
+                }
+            }
+            else {
+                lhs_.EvaluateBlock(first, count, out, valid);
+                auto *rhs = detail::Scratch(buffer_, count);
+                auto *rhs_valid = detail::Scratch(valid_buffer_, Indicator::WordsFor(count));
+                rhs_.EvaluateBlock(first, count, rhs, rhs_valid);
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[i] = op(out[i], rhs[i]);
+                }
+                detail::AndBits(count, valid, rhs_valid);
+            }
+        }
+
+    private:
+        L lhs_;
+        R rhs_;
+
+        //! \brief Space for a block of the right operand, and its validity.
+        mutable std::vector<double> buffer_;
+        mutable std::vector<std::uint64_t> valid_buffer_;
+    };
+
+    //! \brief A comparison of two numeric expressions. Each block is compared by the vectorized comparison kernels, and
+    //! rows that are null in either operand are then cleared.
+    template<typename L, typename R>
+    class ComparisonExpression : public BooleanExpression<ComparisonExpression<L, R>> {
+    public:
+        ComparisonExpression(CompareOp op, L lhs, R rhs) : op_(op), lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+
+        std::size_t Size() const { return detail::CombineSizes(lhs_.Size(), rhs_.Size()); }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, std::uint64_t *out) const {
+            const auto num_words = Indicator::WordsFor(count);
+            auto *valid = detail::Scratch(lhs_valid_, num_words);
+            if constexpr (std::is_same<R, ScalarExpression>::value) {
+                auto *lhs = detail::Scratch(lhs_buffer_, count);
+                lhs_.EvaluateBlock(first, count, lhs, valid);
+                kernels::Compare(op_, lhs, count, rhs_.Value(), out);
+            }
+            else if constexpr (std::is_same<L, ScalarExpression>::value) {
+                auto *rhs = detail::Scratch(rhs_buffer_, count);
+                rhs_.EvaluateBlock(first, count, rhs, valid);
+                kernels::Compare(detail::Mirror(op_), rhs, count, lhs_.Value(), out);
+            }
+            else {
+                auto *lhs = detail::Scratch(lhs_buffer_, count), *rhs = detail::Scratch(rhs_buffer_, count);
+                auto *rhs_valid = detail::Scratch(rhs_valid_, num_words);
+                lhs_.EvaluateBlock(first, count, lhs, valid);
+                rhs_.EvaluateBlock(first, count, rhs, rhs_valid);
+                kernels::CompareColumns(op_, static_cast<const double *>(lhs), static_cast<const double *>(rhs),
+                                        count, out);
+                detail::AndBits(count, out, rhs_valid);
+            }
+            detail::AndBits(count, out, valid);
+        }
+
+    private:
+        CompareOp op_;
+        L lhs_;
+        R rhs_;
+
+        //! \brief Space for a block of each operand, and their validity.
+        mutable std::vector<double> lhs_buffer_, rhs_buffer_;
+        mutable std::vector<std::uint64_t> lhs_valid_, rhs_valid_;
+    };
+
+    //! \brief A logical combination of two boolean expressions. Op is a bitwise function object, like std::bit_and<>,
+    //! which is applied a word at a time.
+    template<typename Op, typename L, typename R>
+    class LogicalExpression : public BooleanExpression<LogicalExpression<Op, L, R>> {
+    public:
+        LogicalExpression(L lhs, R rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {}
+
+        std::size_t Size() const { return detail::CombineSizes(lhs_.Size(), rhs_.Size()); }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, std::uint64_t *out) const {
+            const auto num_words = Indicator::WordsFor(count);
+            auto *rhs = detail::Scratch(buffer_, num_words);
+            lhs_.EvaluateBlock(first, count, out);
+            rhs_.EvaluateBlock(first, count, rhs);
+            Op op;
+            for (std::size_t w = 0; w < num_words; ++w) {
+                out[w] = op(out[w], rhs[w]);
+            }
+        }
+
+    private:
+        L lhs_;
+        R rhs_;
+
+        //! \brief Space for a block of the right operand.
+        mutable std::vector<std::uint64_t> buffer_;
+    };
+
+    //! \brief The negation of a boolean expression.
+    template<typename E>
+    class NotExpression : public BooleanExpression<NotExpression<E>> {
+    public:
+        explicit NotExpression(E operand) : operand_(std::move(operand)) {}
+
+        std::size_t Size() const { return operand_.Size(); }
+
+        void EvaluateBlock(std::size_t first, std::size_t count, std::uint64_t *out) const {
+            operand_.EvaluateBlock(first, count, out);
+            const auto num_words = Indicator::WordsFor(count);
+            for (std::size_t w = 0; w < num_words; ++w) {
+                out[w] = ~out[w];
+            }
+            if (count & 63) {
+                out[num_words - 1] &= (std::uint64_t(1) << (count & 63)) - 1;
+            }
+        }
+
+    private:
+        E operand_;
+    };
+
+    // ========================================
+    //  Building expressions.
+    // ========================================
+
+    namespace detail {
+        template<typename T>
+        constexpr bool kIsNumericExpression = std::is_base_of<NumericTag, T>::value;
+
+        template<typename T>
+        constexpr bool kIsBooleanExpression = std::is_base_of<BooleanTag, T>::value;
+
+        //! \brief Whether a type can be an operand of arithmetic or comparisons in an expression.
+        template<typename T>
+        constexpr bool kIsNumericOperand = kIsNumericExpression<T> || std::is_same<T, DataFrame::Column>::value
+                                           || std::is_arithmetic<T>::value;
+
+        //! \brief Whether a type can be an operand of logical operators in an expression.
+        template<typename T>
+        constexpr bool kIsBooleanOperand = kIsBooleanExpression<T> || std::is_same<T, Indicator>::value;
+
+        //! \brief Arithmetic builds an expression if both operands are numbers, columns, or expressions, and at least
+        //! one of them is not a number.
+        template<typename L, typename R>
+        constexpr bool kArithmeticOperands = kIsNumericOperand<L> && kIsNumericOperand<R>
+                                             && !(std::is_arithmetic<L>::value && std::is_arithmetic<R>::value);
+
+        //! \brief Comparisons build an expression if at least one operand is already an expression. Comparisons of
+        //! plain columns with values are ScalarComparisons, which are declared with the column.
+        template<typename L, typename R>
+        constexpr bool kComparisonOperands = kIsNumericOperand<L> && kIsNumericOperand<R>
+                                             && (kIsNumericExpression<L> || kIsNumericExpression<R>);
+
+        //! \brief Logical operators build an expression if at least one operand is a boolean expression, and the other
+        //! is a boolean expression or an indicator.
+        template<typename L, typename R>
+        constexpr bool kLogicalOperands = kIsBooleanOperand<L> && kIsBooleanOperand<R>
+                                          && (kIsBooleanExpression<L> || kIsBooleanExpression<R>);
+
+        inline ColumnExpression ToExpression(const DataFrame::Column &column) {
+            return ColumnExpression(column);
+        }
+
+        template<typename T, typename = std::enable_if_t<std::is_arithmetic<T>::value>>
+        ScalarExpression ToExpression(T value) {
+            return ScalarExpression(static_cast<double>(value));
+        }
+
+        template<typename E>
+        const E &ToExpression(const NumericExpression<E> &expression) {
+            return static_cast<const E &>(expression);
+        }
+
+        inline IndicatorExpression ToPredicate(const Indicator &indicator) {
+            return IndicatorExpression(indicator);
+        }
+
+        template<typename E>
+        const E &ToPredicate(const BooleanExpression<E> &expression) {
+            return static_cast<const E &>(expression);
+        }
+
+        template<typename T>
+        using expression_t = std::decay_t<decltype(ToExpression(std::declval<const T &>()))>;
+
+        template<typename T>
+        using predicate_t = std::decay_t<decltype(ToPredicate(std::declval<const T &>()))>;
+
+        //! \brief Arithmetic on columns with different numbers of rows is an error, like assigning a vector of the wrong
+        //! size to a column. This throws while the expression is built, so in df["q"] = df["a"] + other["b"], where
+        //! the right side is built first, df["q"] is never created.
+        template<typename Op, typename L, typename R>
+        ArithmeticExpression<Op, expression_t<L>, expression_t<R>> MakeArithmetic(const L &lhs, const R &rhs) {
+            ArithmeticExpression<Op, expression_t<L>, expression_t<R>> expression(ToExpression(lhs), ToExpression(rhs));
+            if (expression.Size() == kMismatchedSize) {
+                throw std::exception();
+            }
+            return expression;
+        }
+
+        template<typename L, typename R>
+        ComparisonExpression<expression_t<L>, expression_t<R>> MakeComparison(
+                CompareOp op, const L &lhs, const R &rhs) {
+            return {op, ToExpression(lhs), ToExpression(rhs)};
+        }
+
+        template<typename Op, typename L, typename R>
+        LogicalExpression<Op, predicate_t<L>, predicate_t<R>> MakeLogical(const L &lhs, const R &rhs) {
+            return {ToPredicate(lhs), ToPredicate(rhs)};
+        }
+    }
+
+    //! \brief Wrap a column in an expression, whose entries are read as doubles. Comparisons of plain columns with
+    //! values are already fused into the expressions they are part of, but they compare entries in the column's own
+    //! type. Comparisons with a wrapped column compare doubles, as the rest of an expression does.
+    inline ColumnExpression Lazy(const DataFrame::Column &column) {
+        return ColumnExpression(column);
+    }
+
+    // ========================================
+    //  Arithmetic operators.
+    // ========================================
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kArithmeticOperands<L, R>>>
+    auto operator+(const L &lhs, const R &rhs) {
+        return detail::MakeArithmetic<std::plus<>>(lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kArithmeticOperands<L, R>>>
+    auto operator-(const L &lhs, const R &rhs) {
+        return detail::MakeArithmetic<std::minus<>>(lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kArithmeticOperands<L, R>>>
+    auto operator*(const L &lhs, const R &rhs) {
+        return detail::MakeArithmetic<std::multiplies<>>(lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kArithmeticOperands<L, R>>>
+    auto operator/(const L &lhs, const R &rhs) {
+        return detail::MakeArithmetic<std::divides<>>(lhs, rhs);
+    }
+
+    // ========================================
+    //  Comparison operators.
+    // ========================================
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kComparisonOperands<L, R>>>
+    auto operator<(const L &lhs, const R &rhs) {
+        return detail::MakeComparison(CompareOp::Lt, lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kComparisonOperands<L, R>>>
+    auto operator<=(const L &lhs, const R &rhs) {
+        return detail::MakeComparison(CompareOp::Le, lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kComparisonOperands<L, R>>>
+    auto operator>(const L &lhs, const R &rhs) {
+        return detail::MakeComparison(CompareOp::Gt, lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kComparisonOperands<L, R>>>
+    auto operator>=(const L &lhs, const R &rhs) {
+        return detail::MakeComparison(CompareOp::Ge, lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kComparisonOperands<L, R>>>
+    auto operator==(const L &lhs, const R &rhs) {
+        return detail::MakeComparison(CompareOp::Eq, lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kComparisonOperands<L, R>>>
+    auto operator!=(const L &lhs, const R &rhs) {
+        return detail::MakeComparison(CompareOp::Ne, lhs, rhs);
+    }
+
+    // ========================================
+    //  Logical operators.
+    // ========================================
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kLogicalOperands<L, R>>>
+    auto operator&(const L &lhs, const R &rhs) {
+        return detail::MakeLogical<std::bit_and<>>(lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kLogicalOperands<L, R>>>
+    auto operator|(const L &lhs, const R &rhs) {
+        return detail::MakeLogical<std::bit_or<>>(lhs, rhs);
+    }
+
+    template<typename L, typename R, typename = std::enable_if_t<detail::kLogicalOperands<L, R>>>
+    auto operator^(const L &lhs, const R &rhs) {
+        return detail::MakeLogical<std::bit_xor<>>(lhs, rhs);
+    }
+
+    template<typename E>
+    NotExpression<E> operator~(const BooleanExpression<E> &expression) {
+        return NotExpression<E>(static_cast<const E &>(expression));
+    }
+
+    // ========================================
+    //  Assigning expressions to columns.
+    // ========================================
+
+    template<typename E>
+    DataFrame::Column& DataFrame::Column::operator=(const NumericExpression<E>& expression) {
+        // Check the size before evaluating anything.
+        if (static_cast<const E&>(expression).Size() != Size() && !(Size() == 0 && GetDType() == DType::None)) {
+            throw std::exception();
+        }
+        Indicator valid;
+        *this = expression.Evaluate(&valid);
+        if (valid.Count() != valid.size()) {
+            auto& validity = box_->wrapper_->validity;
+            (~valid).ForEachTrue([&](std::size_t i) { validity.Set(i, false); });
+        }
+        return *this;
+    }
+
+    template<typename E>
+    DataFrame::Column& DataFrame::Column::operator=(const BooleanExpression<E>& expression) {
+        if (static_cast<const E&>(expression).Size() != Size() && !(Size() == 0 && GetDType() == DType::None)) {
+            throw std::exception();
+        }
+        auto indicator = expression.Evaluate();
+        std::vector<bool> values(indicator.size());
+        indicator.ForEachTrue([&](std::size_t i) { values[i] = true; });
+        return *this = values;
+    }
+
+}
+#endif // __EXPRESSION_H__
@@ -7,69 +7,397 @@
 
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <cstdint>
+
+#include "Indicator.h"
 
 namespace dataframe {
 
-class IndexMap {
-public:
-    IndexMap(const std::vector<std::size_t> &indices, bool empty, std::size_t size)
-            : impl_(std::make_shared<Impl>(indices, empty, size)) {}
+    //! \brief Selects which entries of a column a view of the column sees, in order. The i-th entry of the view is entry
+    //! (*this)[i] of the column. The selected indices always increase.
+    //!
+    //! An index map is stored in whichever of several encodings is smallest for the selection:
+    //!     Full - every entry of the column is selected. This takes no memory, and follows the column as it grows.
+    //!     Range - a contiguous range of entries is selected (an empty selection is an empty range).
+    //!     Indices - a sorted vector of the selected indices, for sparse selections.
+    //!     Bitmap - one bit per entry of the column, for dense selections, with a count of the set bits before every
+    //!         block of words so the i-th selected index can be found quickly.
+    //!
+    //! Copies of an IndexMap refer to the same selection, so adding an index through one copy adds it to all of them.
+    //! Use Clone to get an independent copy. Operations that run over the selection, like ForEach, switch on the
+    //! encoding once and then run a loop specialized for it.
+    class IndexMap {
+    public:
+        enum class Encoding { Full, Range, Indices, Bitmap };
 
-    IndexMap(std::vector<std::size_t> &&indices, bool empty, std::size_t size)
-            : impl_(std::shared_ptr<Impl>(new Impl(std::move(indices), empty, size))) {}
+        //! \brief Create a full index map, which selects every entry.
+        IndexMap() = default;
 
-    bool IsEmpty() const { return impl_->IsEmpty(); }
+        //! \brief Create an index map that selects the size entries starting at first.
+        static IndexMap Range(std::size_t first, std::size_t size) {
+            IndexMap map(Encoding::Range);
+            map.impl_->first = first;
+            map.impl_->size = size;
+            return map;
+        }
 
-    bool IsFull() const { return impl_->IsFull(); }
+        //! \brief Create an index map that selects nothing.
+        static IndexMap None() { return Range(0, 0); }
 
-    std::size_t Size() const { return impl_->Size(); }
+        // ========================================
+        //  Accessors.
+        // ========================================
 
-    std::size_t operator[](std::size_t index) const { return (*impl_)[index]; }
+        //! \brief The encoding of the index map.
+        Encoding GetEncoding() const { return impl_ ? impl_->encoding : Encoding::Full; }
 
-    std::size_t &operator[](std::size_t index) { return (*impl_)[index]; }
+        //! \brief Whether the index map selects every entry.
+        bool IsFull() const { return !impl_; }
 
-    //! \brief Create a copy by value of this index map.
-    IndexMap Clone() const { return IndexMap(impl_->indices_, impl_->empty_, impl_->size_); }
+        //! \brief Whether the index map selects no entries.
+        bool IsEmpty() const { return impl_ && impl_->size == 0; }
 
-private:
-    //! \brief The implementation for the IndexMap. This allows different IndexMaps, copied
-    //! by value, to reference the same underlying data.
-    struct Impl {
-        Impl(const std::vector<std::size_t> &indices, bool empty, std::size_t size)
-                : indices_(indices), empty_(empty), size_(size) {}
+        //! \brief Whether the selected entries are contiguous, i.e. the map is full or a range. The entries are then
+        //! [First(), First() + size).
+        bool IsContiguous() const { return !impl_ || impl_->encoding == Encoding::Range; }
 
-        Impl(std::vector<std::size_t> &&indices, bool empty, std::size_t size)
-                : indices_(std::move(indices)), empty_(empty), size_(size) {}
+        //! \brief The first selected index of a contiguous index map.
+        std::size_t First() const { return impl_ ? impl_->first : 0; }
 
-        bool IsEmpty() const { return empty_; }
+        //! \brief The number of selected entries. A full index map does not know how many entries its column has,
+        //! so this is only meaningful for maps that are not full.
+        std::size_t Size() const { return impl_ ? impl_->size : 0; }
 
-        bool IsFull() const { return !empty_ && indices_.empty(); }
+        //! \brief The number of entries selected from a column with column_size entries.
+        std::size_t Size(std::size_t column_size) const { return impl_ ? impl_->size : column_size; }
 
-        std::size_t Size() const { return size_; }
+        //! \brief The index of the entry that the index-th entry of the view refers to.
+        std::size_t operator[](std::size_t index) const {
+            switch (GetEncoding()) {
+                case Encoding::Full:
+                    return index;
+                case Encoding::Range:
+                    return impl_->first + index;
+                case Encoding::Indices:
+                    return impl_->indices[index];
+                default:
+                    return impl_->Select(index);
+            }
+        }
 
-        std::size_t &operator[](std::size_t index) { return indices_[index]; }
+        //! \brief Something that is the same for all copies of this index map, and different for index maps that are
+        //! not copies of each other. All full maps have the same identity.
+        const void* Identity() const { return impl_.get(); }
 
-        // =========================================================
-        //  Member data.
-        // =========================================================
+        //! \brief The number of selected indices that are less than index, i.e. the position in the view of the first
+        //! entry at or after index. For a full map, this is index, even past the end of the column.
+        std::size_t Rank(std::size_t index) const {
+            switch (GetEncoding()) {
+                case Encoding::Full:
+                    return index;
+                case Encoding::Range:
+                    return std::min(impl_->size, index - std::min(index, impl_->first));
+                case Encoding::Indices: {
+                    const auto& indices = impl_->indices;
+                    return static_cast<std::size_t>(
+                            std::lower_bound(indices.begin(), indices.end(), index) - indices.begin());
+                }
+                default:
+                    return impl_->Rank(index);
+            }
+        }
 
-        //! A map between input indices and the index in the actual underlying data vector.
-        std::vector<std::size_t> indices_;
+        //! \brief The selected indices, for an index map with the indices encoding. Null for other encodings.
+        const std::size_t* Indices() const {
+            return GetEncoding() == Encoding::Indices ? impl_->indices.data() : nullptr;
+        }
 
-        //! \brief Since an empty vector refers to *all* indices being included,
-        //! we need a different flag to track if an empty vector actually means
-        //! *no* indices should be included.
-        bool empty_ = false;
+        //! \brief The indices of the entries of the view in [first, first + count). For the indices encoding, this
+        //! points into the map's own indices. Otherwise, the indices are written into buffer, which must have room for
+        //! count of them, and buffer is returned.
+        const std::size_t* GetIndices(std::size_t first, std::size_t count, std::size_t* buffer) const {
+            if (const auto* indices = Indices()) {
+                return indices + first;
+            }
+            std::size_t i = 0;
+            ForEach(first, first + count, [&](std::size_t index) { buffer[i++] = index; });
+            return buffer;
+        }
 
-        //! \brief Records the size of the index map. When indices_ is not empty, this will
-        //! be the same as indices_.size(). When indices_ is empty and empty_ is false,
-        //! this records the
-        std::size_t size_ = 0;
-    };
+        //! \brief Call f(index) with the index of each of the entries of the view in [first, last), in order.
+        template<typename Function>
+        void ForEach(std::size_t first, std::size_t last, Function&& f) const {
+            if (last <= first) {
+                return;
+            }
+            switch (GetEncoding()) {
+                case Encoding::Full:
+                case Encoding::Range: {
+                    const auto offset = First();
+                    for (std::size_t i = offset + first; i < offset + last; ++i) {
+                        f(i);
+                    }
+                    break;
+                }
+                case Encoding::Indices: {
+                    const auto* indices = impl_->indices.data();
+                    for (std::size_t i = first; i < last; ++i) {
+                        f(indices[i]);
+                    }
+                    break;
+                }
+                case Encoding::Bitmap: {
+                    // Find the first index, then walk the set bits from there.
+                    const auto& words = impl_->words;
+                    const auto start = impl_->Select(first);
+                    std::size_t w = start >> 6, remaining = last - first;
+                    auto word = words[w] & (~std::uint64_t(0) << (start & 63));
+                    while (true) {
+                        while (word) {
+                            f(64 * w + static_cast<std::size_t>(__builtin_ctzll(word)));
+                            if (--remaining == 0) {
+                                return;
+                            }
+                            word &= word - 1;
+                        }
+                        word = words[++w];
+                    }
+                }
+            }
+        }
+
+        //! \brief Call f(index) with the index of each of the first size entries of the view, in order. For a full
+        //! map, size is the size of the column.
+        template<typename Function>
+        void ForEach(std::size_t size, Function&& f) const {
+            ForEach(0, size, std::forward<Function>(f));
+        }
+
+        // ========================================
+        //  Creating new index maps.
+        // ========================================
+
+        //! \brief Create an index map that selects the entries of this one at the positions where indicator is true.
+        //! The encoding of the new map is chosen from how many entries are selected, and how spread out they are.
+        IndexMap Select(const Indicator& indicator) const {
+            const auto count = indicator.Count();
+            if (count == 0) {
+                return None();
+            }
+            const auto first_position = indicator.FindFirst(), last_position = indicator.FindLast();
+            return Build(count, (*this)[first_position], (*this)[last_position], [&](auto&& add) {
+                switch (GetEncoding()) {
+                    case Encoding::Full:
+                    case Encoding::Range: {
+                        const auto offset = First();
+                        indicator.ForEachTrue([&](std::size_t position) { add(offset + position); });
+                        break;
+                    }
+                    case Encoding::Indices: {
+                        const auto* indices = impl_->indices.data();
+                        indicator.ForEachTrue([&](std::size_t position) { add(indices[position]); });
+                        break;
+                    }
+                    case Encoding::Bitmap: {
+                        // Walk the bitmap and the indicator together.
+                        std::size_t position = first_position;
+                        ForEach(first_position, last_position + 1, [&](std::size_t index) {
+                            if (indicator[position++]) {
+                                add(index);
+                            }
+                        });
+                        break;
+                    }
+                }
+            });
+        }
+
+        //! \brief Create an index map that selects the entries of this one at positions [first, last), with offset
+        //! subtracted from each of their indices. This is how a view of a column is split into views of the separate
+        //! blocks that the column is stored in.
+        IndexMap Slice(std::size_t first, std::size_t last, std::size_t offset) const {
+            if (last <= first) {
+                return None();
+            }
+            if (IsContiguous()) {
+                return Range(First() + first - offset, last - first);
+            }
+            return Build(last - first, (*this)[first] - offset, (*this)[last - 1] - offset, [&](auto&& add) {
+                ForEach(first, last, [&](std::size_t index) { add(index - offset); });
+            });
+        }
+
+        //! \brief Create a copy by value of this index map.
+        IndexMap Clone() const {
+            IndexMap map;
+            if (impl_) {
+                map.impl_ = std::make_shared<Impl>(*impl_);
+            }
+            return map;
+        }
+
+        // ========================================
+        //  Modifiers.
+        // ========================================
+
+        //! \brief Add an index to the selection. The index must be larger than any index already in the map. Full
+        //! index maps already select every index, so this does nothing to them.
+        void PushBack(std::size_t index) {
+            if (!impl_) {
+                return;
+            }
+            auto& impl = *impl_;
+            switch (impl.encoding) {
+                case Encoding::Range:
+                    if (impl.size == 0) {
+                        impl.first = index;
+                        impl.size = 1;
+                    }
+                    else if (index == impl.first + impl.size) {
+                        ++impl.size;
+                    }
+                    else {
+                        // The range has to be re-encoded.
+                        auto first = impl.first, size = impl.size;
+                        *impl_ = *Build(size + 1, first, index, [&](auto&& add) {
+                            for (std::size_t i = first; i < first + size; ++i) {
+                                add(i);
+                            }
+                            add(index);
+                        }).impl_;
+                    }
+                    break;
+                case Encoding::Indices:
+                    impl.indices.push_back(index);
+                    ++impl.size;
+                    break;
+                case Encoding::Bitmap:
+                    impl.AddBit(index);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+    private:
+        //! \brief Indices are 64 bits, so a sorted vector of indices is smaller than a bitmap when fewer than one in 64
+        //! of the entries it spans are selected.
+        static constexpr std::size_t kBitsPerIndex = 64;
+
+        //! \brief The number of bitmap words in each block that a count of the preceding set bits is kept for.
+        static constexpr std::size_t kWordsPerBlock = 8;
+
+        //! \brief The data of a non-full index map. This allows different IndexMaps, copied by value, to reference the
+        //! same selection.
+        struct Impl {
+            explicit Impl(Encoding encoding) : encoding(encoding) {}
 
-    //! \brief The implementation for the IndexMap.
-    std::shared_ptr<Impl> impl_;
-};
+            //! \brief The index of the set bit with the specified rank in the bitmap.
+            std::size_t Select(std::size_t rank) const {
+                // The last block whose count of preceding set bits is not more than the rank.
+                auto block = static_cast<std::size_t>(
+                        std::upper_bound(block_counts.begin(), block_counts.end(), rank) - block_counts.begin() - 1);
+                rank -= block_counts[block];
+                auto w = block * kWordsPerBlock;
+                for (;; ++w) {
+                    auto bits = static_cast<std::size_t>(__builtin_popcountll(words[w]));
+                    if (rank < bits) {
+                        break;
+                    }
+                    rank -= bits;
+                }
+                auto word = words[w];
+                for (; rank; --rank) {
+                    word &= word - 1;
+                }
+                return 64 * w + static_cast<std::size_t>(__builtin_ctzll(word));
+            }
+
+            //! \brief The number of set bits of the bitmap before the specified index.
+            std::size_t Rank(std::size_t index) const {
+                auto w = index >> 6;
+                if (words.size() <= w) {
+                    return size;
+                }
+                auto block = w / kWordsPerBlock;
+                auto rank = block_counts[block];
+                for (auto v = block * kWordsPerBlock; v < w; ++v) {
+                    rank += static_cast<std::size_t>(__builtin_popcountll(words[v]));
+                }
+                auto mask = (std::uint64_t(1) << (index & 63)) - 1;
+                return rank + static_cast<std::size_t>(__builtin_popcountll(words[w] & mask));
+            }
+
+            //! \brief Set a bit of the bitmap, which must be past every bit that is already set.
+            void AddBit(std::size_t index) {
+                while (words.size() <= (index >> 6)) {
+                    if (words.size() % kWordsPerBlock == 0) {
+                        block_counts.push_back(size);
+                    }
+                    words.push_back(0);
+                }
+                words[index >> 6] |= std::uint64_t(1) << (index & 63);
+                ++size;
+            }
+
+            //! \brief How the selection is stored.
+            Encoding encoding;
+
+            //! \brief The number of selected entries.
+            std::size_t size = 0;
+
+            //! \brief The first index of a range.
+            std::size_t first = 0;
+
+            //! \brief The selected indices, for the indices encoding.
+            std::vector<std::size_t> indices;
+
+            //! \brief The bits of the bitmap encoding. Bit (i % 64) of word (i / 64) is set if index i is selected.
+            std::vector<std::uint64_t> words;
+
+            //! \brief For the bitmap encoding, the number of set bits before each block of kWordsPerBlock words.
+            std::vector<std::size_t> block_counts;
+        };
+
+        explicit IndexMap(Encoding encoding) : impl_(std::make_shared<Impl>(encoding)) {}
+
+        //! \brief Build a (non-full) index map that selects count indices, the smallest being first and the largest
+        //! being last. The indices are added, in increasing order, by calling generate(add), which calls add(index)
+        //! with each index.
+        template<typename Generate>
+        static IndexMap Build(std::size_t count, std::size_t first, std::size_t last, Generate&& generate) {
+            auto span = last - first + 1;
+            if (count == span) {
+                return Range(first, count);
+            }
+            if (count * kBitsPerIndex < span) {
+                IndexMap map(Encoding::Indices);
+                auto& indices = map.impl_->indices;
+                indices.reserve(count);
+                generate([&](std::size_t index) { indices.push_back(index); });
+                map.impl_->size = count;
+                return map;
+            }
+            IndexMap map(Encoding::Bitmap);
+            auto& impl = *map.impl_;
+            impl.words.assign((last >> 6) + 1, 0);
+            generate([&](std::size_t index) { impl.words[index >> 6] |= std::uint64_t(1) << (index & 63); });
+            impl.size = count;
+            impl.block_counts.reserve((impl.words.size() + kWordsPerBlock - 1) / kWordsPerBlock);
+            std::size_t set_bits = 0;
+            for (std::size_t w = 0; w < impl.words.size(); ++w) {
+                if (w % kWordsPerBlock == 0) {
+                    impl.block_counts.push_back(set_bits);
+                }
+                set_bits += static_cast<std::size_t>(__builtin_popcountll(impl.words[w]));
+            }
+            return map;
+        }
+
+        //! \brief The selection, or null for a full index map.
+        std::shared_ptr<Impl> impl_;
+    };
 
 }
 #endif //DATAFRAME_INDEXMAP_H
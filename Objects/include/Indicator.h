@@ -0,0 +1,312 @@
+//
+// Created by Nathaniel Rupprecht on 6/2/21.
+//
+
+#ifndef __INDICATOR_H__
+#define __INDICATOR_H__
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace dataframe {
+
+    namespace detail {
+        //! \brief Combine num_words words of lhs and rhs into out, using op for any words that are not done with SIMD
+        //! instructions, and simd_op for the rest. Out may be the same as lhs or rhs.
+        template<typename Op, typename SimdOp>
+        inline void CombineWords(std::uint64_t *out, const std::uint64_t *lhs, const std::uint64_t *rhs,
+                                 std::size_t num_words, Op &&op, SimdOp &&simd_op) {
+            std::size_t w = 0;
+#if defined(__AVX2__)
+            for (; w + 4 <= num_words; w += 4) {
+                auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + w));
+                auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + w));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + w), simd_op(a, b));
+            }
+#elif defined(__SSE2__)
+            for (; w + 2 <= num_words; w += 2) {
+                auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + w));
+                auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + w));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + w), simd_op(a, b));
+            }
+#endif
+            for (; w < num_words; ++w) {
+                out[w] = op(lhs[w], rhs[w]);
+            }
+        }
+    }
+
+    //! \brief Indicators are returned from column comparisons and used to select new views of DataFrames. An indicator
+    //! is a sequence of bools, packed 64 to a word, so they can be combined, negated, and counted a word (or a SIMD
+    //! register) at a time.
+    //!
+    //! Entry i is bit (i % 64) of word (i / 64). The bits past the last entry are always zero.
+    class Indicator {
+    public:
+        // ========================================
+        //  Constructors.
+        // ========================================
+
+        //! \brief Create an empty indicator.
+        Indicator() = default;
+
+        //! \brief Create an indicator with size entries, all of which have the specified value.
+        explicit Indicator(std::size_t size, bool value = false)
+                : words_(WordsFor(size), value ? ~std::uint64_t(0) : 0), size_(size) {
+            ClearTail();
+        }
+
+        //! \brief Create an indicator from a vector of bools.
+        Indicator(const std::vector<bool> &values) : words_(WordsFor(values.size()), 0), size_(values.size()) {
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                words_[i >> 6] |= static_cast<std::uint64_t>(values[i]) << (i & 63);
+            }
+        }
+
+        //! \brief Create an indicator with size entries, where entry i is predicate(i). The entries are computed a word
+        //! at a time, without branching.
+        template<typename Predicate>
+        static Indicator Generate(std::size_t size, Predicate &&predicate) {
+            Indicator output;
+            output.size_ = size;
+            output.words_.resize(WordsFor(size));
+            for (std::size_t w = 0; w < output.words_.size(); ++w) {
+                std::uint64_t word = 0;
+                const auto first = 64 * w, count = std::min<std::size_t>(64, size - first);
+                for (std::size_t j = 0; j < count; ++j) {
+                    word |= static_cast<std::uint64_t>(static_cast<bool>(predicate(first + j))) << j;
+                }
+                output.words_[w] = word;
+            }
+            return output;
+        }
+
+        // ========================================
+        //  Accessors.
+        // ========================================
+
+        //! \brief The number of entries.
+        std::size_t size() const { return size_; }
+
+        //! \brief Whether there are no entries.
+        bool empty() const { return size_ == 0; }
+
+        //! \brief The value of an entry.
+        bool operator[](std::size_t index) const { return (words_[index >> 6] >> (index & 63)) & 1; }
+
+        //! \brief The number of true entries.
+        std::size_t Count() const {
+            std::size_t count = 0;
+            for (auto word : words_) {
+                count += static_cast<std::size_t>(__builtin_popcountll(word));
+            }
+            return count;
+        }
+
+        //! \brief Whether every entry is true. This is true for an empty indicator.
+        bool All() const {
+            const auto full_words = size_ >> 6;
+            for (std::size_t w = 0; w < full_words; ++w) {
+                if (words_[w] != ~std::uint64_t(0)) {
+                    return false;
+                }
+            }
+            return (size_ & 63) == 0 || words_.back() == (std::uint64_t(1) << (size_ & 63)) - 1;
+        }
+
+        //! \brief Whether any entry is true.
+        bool Any() const {
+            return std::any_of(words_.begin(), words_.end(), [](std::uint64_t word) { return word != 0; });
+        }
+
+        //! \brief Whether no entry is true.
+        bool None() const { return !Any(); }
+
+        //! \brief The index of the first true entry, or size() if there is none.
+        std::size_t FindFirst() const {
+            for (std::size_t w = 0; w < words_.size(); ++w) {
+                if (words_[w]) {
+                    return 64 * w + static_cast<std::size_t>(__builtin_ctzll(words_[w]));
+                }
+            }
+            return size_;
+        }
+
+        //! \brief The index of the last true entry, or size() if there is none.
+        std::size_t FindLast() const {
+            for (std::size_t w = words_.size(); w-- > 0;) {
+                if (words_[w]) {
+                    return 64 * w + 63 - static_cast<std::size_t>(__builtin_clzll(words_[w]));
+                }
+            }
+            return size_;
+        }
+
+        //! \brief Call f(index) with the index of every true entry, in order. Words without any true entries are
+        //! skipped, and the true entries of a word are found with count-trailing-zeros.
+        template<typename Function>
+        void ForEachTrue(Function &&f) const {
+            for (std::size_t w = 0; w < words_.size(); ++w) {
+                auto word = words_[w];
+                while (word) {
+                    f(64 * w + static_cast<std::size_t>(__builtin_ctzll(word)));
+                    word &= word - 1;
+                }
+            }
+        }
+
+        //! \brief The words of the indicator.
+        const std::vector<std::uint64_t> &Words() const { return words_; }
+
+        //! \brief The words of the indicator. Bits past the last entry must be left zero.
+        std::vector<std::uint64_t> &Words() { return words_; }
+
+        // ========================================
+        //  Modifiers.
+        // ========================================
+
+        //! \brief Set the value of an entry.
+        void Set(std::size_t index, bool value = true) {
+            auto bit = std::uint64_t(1) << (index & 63);
+            value ? words_[index >> 6] |= bit : words_[index >> 6] &= ~bit;
+        }
+
+        //! \brief Add an entry.
+        void push_back(bool value) {
+            if ((size_ & 63) == 0) {
+                words_.push_back(0);
+            }
+            words_.back() |= static_cast<std::uint64_t>(value) << (size_ & 63);
+            ++size_;
+        }
+
+        //! \brief Reserve space for a number of entries.
+        void reserve(std::size_t size) { words_.reserve(WordsFor(size)); }
+
+        //! \brief Add the entries of another indicator after the entries of this one.
+        void Append(const Indicator &other) {
+            auto shift = size_ & 63;
+            if (shift == 0) {
+                words_.insert(words_.end(), other.words_.begin(), other.words_.end());
+            }
+            else {
+                words_.resize(WordsFor(size_ + other.size_), 0);
+                const auto base = size_ >> 6;
+                for (std::size_t w = 0; w < other.words_.size(); ++w) {
+                    words_[base + w] |= other.words_[w] << shift;
+                    if (base + w + 1 < words_.size()) {
+                        words_[base + w + 1] |= other.words_[w] >> (64 - shift);
+                    }
+                }
+            }
+            size_ += other.size_;
+        }
+
+        // ========================================
+        //  Logical operators.
+        // ========================================
+
+        //! \brief Combine with another indicator, entry by entry. If the sizes differ, the result has the smaller size.
+        Indicator &operator&=(const Indicator &rhs) {
+            Shrink(rhs.size_);
+            detail::CombineWords(words_.data(), words_.data(), rhs.words_.data(), words_.size(),
+                                 [](std::uint64_t a, std::uint64_t b) { return a & b; },
+                                 [](auto a, auto b) { return And(a, b); });
+            return *this;
+        }
+
+        Indicator &operator|=(const Indicator &rhs) {
+            Shrink(rhs.size_);
+            detail::CombineWords(words_.data(), words_.data(), rhs.words_.data(), words_.size(),
+                                 [](std::uint64_t a, std::uint64_t b) { return a | b; },
+                                 [](auto a, auto b) { return Or(a, b); });
+            ClearTail();
+            return *this;
+        }
+
+        Indicator &operator^=(const Indicator &rhs) {
+            Shrink(rhs.size_);
+            detail::CombineWords(words_.data(), words_.data(), rhs.words_.data(), words_.size(),
+                                 [](std::uint64_t a, std::uint64_t b) { return a ^ b; },
+                                 [](auto a, auto b) { return Xor(a, b); });
+            ClearTail();
+            return *this;
+        }
+
+        //! \brief Negate every entry.
+        Indicator &Flip() {
+            detail::CombineWords(words_.data(), words_.data(), words_.data(), words_.size(),
+                                 [](std::uint64_t a, std::uint64_t) { return ~a; },
+                                 [](auto a, auto) { return Not(a); });
+            ClearTail();
+            return *this;
+        }
+
+        //! \brief The number of words needed for a number of entries.
+        static std::size_t WordsFor(std::size_t size) { return (size + 63) >> 6; }
+
+    private:
+        //! \brief If size is smaller than the number of entries, remove the entries past size.
+        void Shrink(std::size_t size) {
+            if (size < size_) {
+                size_ = size;
+                words_.resize(WordsFor(size));
+                ClearTail();
+            }
+        }
+
+        //! \brief Zero the bits past the last entry.
+        void ClearTail() {
+            if (size_ & 63) {
+                words_.back() &= (std::uint64_t(1) << (size_ & 63)) - 1;
+            }
+        }
+
+#if defined(__AVX2__)
+        static __m256i And(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+        static __m256i Or(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+        static __m256i Xor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+        static __m256i Not(__m256i a) { return _mm256_xor_si256(a, _mm256_set1_epi64x(-1)); }
+#elif defined(__SSE2__)
+        static __m128i And(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+        static __m128i Or(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+        static __m128i Xor(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+        static __m128i Not(__m128i a) { return _mm_xor_si128(a, _mm_set1_epi64x(-1)); }
+#endif
+
+        //! \brief The entries, 64 to a word.
+        std::vector<std::uint64_t> words_;
+
+        //! \brief The number of entries.
+        std::size_t size_ = 0;
+    };
+
+    // ========================================
+    //  Helpful operators for combining or modifying Indicators.
+    // ========================================
+
+    inline Indicator operator&(Indicator lhs, const Indicator &rhs) {
+        return lhs &= rhs;
+    }
+
+    inline Indicator operator|(Indicator lhs, const Indicator &rhs) {
+        return lhs |= rhs;
+    }
+
+    inline Indicator operator^(Indicator lhs, const Indicator &rhs) {
+        return lhs ^= rhs;
+    }
+
+    inline Indicator operator~(Indicator lhs) {
+        return lhs.Flip();
+    }
+
+}
+#endif // __INDICATOR_H__
@@ -0,0 +1,56 @@
+//
+// Created by Nathaniel Rupprecht on 5/16/21.
+//
+
+#ifndef __MEMORY_MAP_H__
+#define __MEMORY_MAP_H__
+
+#include <string>
+#include <string_view>
+
+namespace dataframe {
+
+    //! \brief A read-only memory mapping of a file. The mapping is released when the object is destroyed.
+    //!
+    //! On platforms without mmap, the file is read into memory instead, so the object can be used the same way.
+    class MemoryMappedFile {
+    public:
+        MemoryMappedFile() = default;
+
+        //! \brief Map a file. Check IsOpen() to see if the mapping succeeded.
+        explicit MemoryMappedFile(const std::string &filename);
+
+        MemoryMappedFile(const MemoryMappedFile &) = delete;
+
+        MemoryMappedFile &operator=(const MemoryMappedFile &) = delete;
+
+        ~MemoryMappedFile();
+
+        //! \brief Whether the file was successfully mapped.
+        bool IsOpen() const { return is_open_; }
+
+        //! \brief A pointer to the beginning of the mapped file.
+        const char *Data() const { return data_; }
+
+        //! \brief The size of the mapped file, in bytes.
+        std::size_t Size() const { return size_; }
+
+        //! \brief A view of the entire mapped file.
+        std::string_view View() const { return std::string_view(data_, size_); }
+
+    private:
+        //! \brief The beginning of the mapped memory.
+        const char *data_ = nullptr;
+
+        //! \brief The size of the mapped memory.
+        std::size_t size_ = 0;
+
+        //! \brief Whether the file was successfully mapped.
+        bool is_open_ = false;
+
+        //! \brief If the file could not be mapped, and was read in instead, the data lives here.
+        std::string fallback_;
+    };
+
+}
+#endif // __MEMORY_MAP_H__
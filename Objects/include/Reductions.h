@@ -0,0 +1,100 @@
+//
+// Created by Nathaniel Rupprecht on 6/12/21.
+//
+
+#ifndef __REDUCTIONS_H__
+#define __REDUCTIONS_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+
+namespace dataframe {
+
+    //! \brief The type that the entries of integer columns are summed in. A sum of 64 bit integers in this type cannot
+    //! overflow for any column that fits in memory.
+    using IntegerSum = __int128;
+
+    //! \brief Summary statistics of the entries of a column. Null entries, and NaNs, are skipped. Statistics that are
+    //! not defined (the mean of no entries, the variance of fewer than two) are NaN.
+    struct Statistics {
+        //! \brief The number of entries that the statistics are of.
+        std::size_t count = 0;
+
+        //! \brief The sum. For integer columns, this is the exact sum rounded to the nearest double, which may not be
+        //! the exact sum if it is larger than 2^53. The min and max of such large integers are rounded too.
+        double sum = 0.;
+        double mean = std::numeric_limits<double>::quiet_NaN();
+        double min = std::numeric_limits<double>::quiet_NaN();
+        double max = std::numeric_limits<double>::quiet_NaN();
+
+        //! \brief The sample variance, i.e. the sum of squared deviations from the mean divided by count - 1.
+        double variance = std::numeric_limits<double>::quiet_NaN();
+
+        //! \brief The sample standard deviation.
+        double Std() const { return std::sqrt(variance); }
+    };
+
+    //! \brief Accumulates statistics a block of values at a time. Each block is reduced by the vectorized kernels: once
+    //! for the count, sum, min and max, and, if the variance is wanted, a second time, while the block is still in
+    //! cache, for the sum of squared deviations from the block's mean. Blocks, and accumulators for other parts of a column, are then merged with
+    //! the pairwise update of Chan et al., and sums are added with Neumaier's compensation, so the results stay
+    //! accurate for long columns of floats.
+    class StatisticsAccumulator {
+    public:
+        //! \brief The largest number of values that should be added at once. A block of doubles this size fits in L1.
+        static constexpr std::size_t kBlockSize = 1024;
+
+        //! \brief The fewest values that are worth reducing on a thread of their own.
+        static constexpr std::size_t kMinThreadSize = std::size_t(1) << 18;
+
+        //! \brief Create an accumulator. If with_variance is false, each block is only reduced once, and the variance
+        //! of the result is NaN.
+        explicit StatisticsAccumulator(bool with_variance = true) : with_variance_(with_variance) {}
+
+        //! \brief Add a block of values. NaNs are skipped.
+        void Add(const double *values, std::size_t size);
+
+        //! \brief Add the exact sum of integers that were also added as doubles. If this is used, the sum of the result
+        //! is the exact sum of the integers, rounded once, instead of the sum of the doubles, each of which may have been
+        //! rounded.
+        void AddIntegerSum(IntegerSum sum) {
+            integer_sum_ += sum;
+            has_integer_sum_ = true;
+        }
+
+        //! \brief Add the values that another accumulator has accumulated.
+        void Merge(const StatisticsAccumulator &other);
+
+        //! \brief The statistics of everything accumulated so far.
+        Statistics Result() const;
+
+    private:
+        bool with_variance_;
+        std::size_t count_ = 0;
+        double sum_ = 0., compensation_ = 0.;
+        double mean_ = 0., m2_ = 0.;
+        double min_ = std::numeric_limits<double>::infinity();
+        double max_ = -std::numeric_limits<double>::infinity();
+        IntegerSum integer_sum_ = 0;
+        bool has_integer_sum_ = false;
+    };
+
+    namespace kernels {
+
+        //! \brief The count, sum, min and max of the values of a block that are not NaN.
+        struct BlockSums {
+            std::size_t count;
+            double sum, min, max;
+        };
+
+        //! \brief Reduce data[0, size), skipping NaNs. The instruction set is the one that the comparison kernels use.
+        BlockSums SumMinMax(const double *data, std::size_t size);
+
+        //! \brief The sum of (data[i] - mean)^2 over the entries of data[0, size) that are not NaN.
+        double SumSquaredDeviations(const double *data, std::size_t size, double mean);
+    }
+
+}
+#endif // __REDUCTIONS_H__
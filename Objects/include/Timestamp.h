@@ -0,0 +1,314 @@
+//
+// Created by Nathaniel Rupprecht on 5/25/21.
+//
+
+#ifndef __TIMESTAMP_H__
+#define __TIMESTAMP_H__
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <exception>
+
+namespace dataframe {
+
+    //! \brief A point in time, stored as the number of seconds since the Unix epoch, 1970-01-01 00:00:00 UTC.
+    struct Timestamp {
+        //! \brief The timestamp of a date and time in UTC.
+        static Timestamp FromCivil(int year, int month, int day, int hour = 0, int minute = 0, int second = 0);
+
+        bool operator==(const Timestamp &rhs) const { return seconds == rhs.seconds; }
+
+        bool operator!=(const Timestamp &rhs) const { return seconds != rhs.seconds; }
+
+        bool operator<(const Timestamp &rhs) const { return seconds < rhs.seconds; }
+
+        bool operator<=(const Timestamp &rhs) const { return seconds <= rhs.seconds; }
+
+        bool operator>(const Timestamp &rhs) const { return seconds > rhs.seconds; }
+
+        bool operator>=(const Timestamp &rhs) const { return seconds >= rhs.seconds; }
+
+        //! \brief Seconds since the epoch.
+        std::int64_t seconds = 0;
+    };
+
+    namespace detail {
+        //! \brief The number of days from 1970-01-01 to a date in the proleptic Gregorian calendar.
+        inline std::int64_t DaysFromCivil(std::int64_t year, int month, int day) {
+            year -= month <= 2;
+            const std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const auto year_of_era = year - era * 400;
+            const auto day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const auto day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            return era * 146097 + day_of_era - 719468;
+        }
+
+        //! \brief The date that is a number of days after 1970-01-01. The inverse of DaysFromCivil.
+        inline void CivilFromDays(std::int64_t days, std::int64_t &year, int &month, int &day) {
+            days += 719468;
+            const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const auto day_of_era = days - era * 146097;
+            const auto year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+            const auto day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+            const auto mp = (5 * day_of_year + 2) / 153;
+            day = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+            month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+            year = year_of_era + era * 400 + (month <= 2);
+        }
+
+        inline int DaysInMonth(std::int64_t year, int month) {
+            constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+            bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+            return month == 2 && leap ? 29 : days[month - 1];
+        }
+
+        //! \brief Match one of a list of three letter names at text[i]. Returns the index of the name, or -1.
+        inline int MatchName(std::string_view text, std::size_t &i, const char *const *names, int num_names) {
+            if (text.size() < i + 3) {
+                return -1;
+            }
+            for (int n = 0; n < num_names; ++n) {
+                if (text.compare(i, 3, names[n], 3) == 0) {
+                    i += 3;
+                    return n;
+                }
+            }
+            return -1;
+        }
+
+        //! \brief Consume between min_digits and max_digits ascii digits starting at text[i].
+        inline bool ConsumeNumber(std::string_view text, std::size_t &i, int min_digits, int max_digits, int &value) {
+            value = 0;
+            int count = 0;
+            for (; count < max_digits && i < text.size() && static_cast<unsigned char>(text[i] - '0') < 10;
+                   ++count, ++i) {
+                value = 10 * value + (text[i] - '0');
+            }
+            return min_digits <= count;
+        }
+    }
+
+    inline Timestamp Timestamp::FromCivil(int year, int month, int day, int hour, int minute, int second) {
+        return Timestamp{detail::DaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second};
+    }
+
+    //! \brief A format for reading timestamps from text, in the style of strptime. The format string is compiled
+    //! once into a list of steps, so parsing a field never looks at the format string again.
+    //!
+    //! The directives are %Y (a four digit year), %m, %d, %H, %M, %S (the month, day, hour, minute, and second, as
+    //! one or two digits), %b (an abbreviated month name, like May), %a (an abbreviated weekday name, which is checked
+    //! but otherwise ignored), %Z (a time zone abbreviation: UTC, GMT, or the US zones EST, EDT, CST, CDT, MST, MDT,
+    //! PST, and PDT), %z (an offset from UTC, like +0200 or Z), and %%. A space matches any number of spaces, and any
+    //! other character matches itself. Times are converted to UTC using the time zone, if there is one.
+    class TimestampFormat {
+    public:
+        //! \brief An empty format, which does not parse anything.
+        TimestampFormat() = default;
+
+        //! \brief Compile a format string. Throws if the format contains an unknown directive.
+        explicit TimestampFormat(std::string_view format) {
+            for (std::size_t i = 0; i < format.size(); ++i) {
+                if (format[i] == ' ') {
+                    steps_.push_back({Step::Space, ' '});
+                    while (i + 1 < format.size() && format[i + 1] == ' ') {
+                        ++i;
+                    }
+                }
+                else if (format[i] != '%') {
+                    steps_.push_back({Step::Literal, format[i]});
+                }
+                else if (++i == format.size()) {
+                    throw std::exception();
+                }
+                else {
+                    switch (format[i]) {
+                        case 'Y': steps_.push_back({Step::Year, 0}); break;
+                        case 'm': steps_.push_back({Step::Month, 0}); break;
+                        case 'd': steps_.push_back({Step::Day, 0}); break;
+                        case 'H': steps_.push_back({Step::Hour, 0}); break;
+                        case 'M': steps_.push_back({Step::Minute, 0}); break;
+                        case 'S': steps_.push_back({Step::Second, 0}); break;
+                        case 'b': steps_.push_back({Step::MonthName, 0}); break;
+                        case 'a': steps_.push_back({Step::WeekdayName, 0}); break;
+                        case 'Z': steps_.push_back({Step::ZoneName, 0}); break;
+                        case 'z': steps_.push_back({Step::ZoneOffset, 0}); break;
+                        case '%': steps_.push_back({Step::Literal, '%'}); break;
+                        default:
+                            throw std::exception();
+                    }
+                }
+            }
+        }
+
+        //! \brief Parse the whole of a field as a timestamp. Returns false, leaving the timestamp unchanged, if the
+        //! field does not match the format or is not a valid date and time.
+        bool Parse(std::string_view text, Timestamp &timestamp) const {
+            static const char *const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+            static const char *const kWeekdays[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+            static const char *const kZones[] = {"UTC", "GMT", "EST", "EDT", "CST", "CDT", "MST", "MDT", "PST", "PDT"};
+            static const int kZoneHours[] = {0, 0, -5, -4, -6, -5, -7, -6, -8, -7};
+
+            if (steps_.empty()) {
+                return false;
+            }
+            int year = 1970, month = 1, day = 1, hour = 0, minute = 0, second = 0, offset = 0;
+            std::size_t i = 0;
+            for (const auto &step : steps_) {
+                bool ok = true;
+                switch (step.first) {
+                    case Step::Literal:
+                        ok = i < text.size() && text[i++] == step.second;
+                        break;
+                    case Step::Space:
+                        ok = i < text.size() && text[i] == ' ';
+                        for (; i < text.size() && text[i] == ' '; ++i);
+                        break;
+                    case Step::Year:
+                        ok = detail::ConsumeNumber(text, i, 4, 4, year);
+                        break;
+                    case Step::Month:
+                        ok = detail::ConsumeNumber(text, i, 1, 2, month);
+                        break;
+                    case Step::Day:
+                        ok = detail::ConsumeNumber(text, i, 1, 2, day);
+                        break;
+                    case Step::Hour:
+                        ok = detail::ConsumeNumber(text, i, 1, 2, hour);
+                        break;
+                    case Step::Minute:
+                        ok = detail::ConsumeNumber(text, i, 1, 2, minute);
+                        break;
+                    case Step::Second:
+                        ok = detail::ConsumeNumber(text, i, 1, 2, second);
+                        break;
+                    case Step::MonthName: {
+                        int index = detail::MatchName(text, i, kMonths, 12);
+                        ok = 0 <= index;
+                        month = index + 1;
+                        break;
+                    }
+                    case Step::WeekdayName:
+                        ok = 0 <= detail::MatchName(text, i, kWeekdays, 7);
+                        break;
+                    case Step::ZoneName: {
+                        int index = detail::MatchName(text, i, kZones, 10);
+                        ok = 0 <= index;
+                        offset = ok ? kZoneHours[index] * 3600 : 0;
+                        break;
+                    }
+                    case Step::ZoneOffset: {
+                        if (i < text.size() && text[i] == 'Z') {
+                            ++i;
+                            offset = 0;
+                            break;
+                        }
+                        ok = i < text.size() && (text[i] == '+' || text[i] == '-');
+                        int hours = 0, minutes = 0;
+                        if (ok) {
+                            bool negative = text[i++] == '-';
+                            ok = detail::ConsumeNumber(text, i, 2, 2, hours);
+                            if (ok && i < text.size() && text[i] == ':') {
+                                ++i;
+                            }
+                            ok = ok && detail::ConsumeNumber(text, i, 2, 2, minutes);
+                            offset = (negative ? -1 : 1) * (hours * 3600 + minutes * 60);
+                        }
+                        break;
+                    }
+                }
+                if (!ok) {
+                    return false;
+                }
+            }
+            if (i != text.size() || month < 1 || 12 < month || day < 1 || detail::DaysInMonth(year, month) < day
+                || 23 < hour || 59 < minute || 60 < second) {
+                return false;
+            }
+            timestamp = Timestamp{Timestamp::FromCivil(year, month, day, hour, minute, second).seconds - offset};
+            return true;
+        }
+
+        //! \brief Whether the format is empty, and so does not parse anything.
+        bool Empty() const {
+            return steps_.empty();
+        }
+
+    private:
+        enum class Step : char {
+            Literal, Space, Year, Month, Day, Hour, Minute, Second, MonthName, WeekdayName, ZoneName, ZoneOffset
+        };
+
+        //! \brief The steps of the format, and the character that each literal step matches.
+        std::vector<std::pair<Step, char>> steps_;
+    };
+
+    //! \brief Try to read a field as a timestamp in one of the formats that timestamps are inferred from: ISO 8601
+    //! dates, like 2008-05-21, ISO 8601 date times, like 2008-05-21 13:45:00 or 2008-05-21T13:45:00Z, and the format
+    //! that date(1) writes, like Wed May 21 00:00:00 EDT 2008. Fields that cannot be any of these are rejected by
+    //! their length and a few characters, without trying the formats.
+    inline bool InferTimestamp(std::string_view text, Timestamp &timestamp) {
+        if (text.size() < 10 || 32 < text.size()) {
+            return false;
+        }
+        if (text[4] == '-') {
+            static const TimestampFormat kISOFormats[] = {
+                    TimestampFormat("%Y-%m-%d"), TimestampFormat("%Y-%m-%d %H:%M:%S"),
+                    TimestampFormat("%Y-%m-%dT%H:%M:%S"), TimestampFormat("%Y-%m-%dT%H:%M:%S%z")
+            };
+            for (const auto &format : kISOFormats) {
+                if (format.Parse(text, timestamp)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (text[3] == ' ' && 'A' <= text[0] && text[0] <= 'Z') {
+            static const TimestampFormat kDateFormat("%a %b %d %H:%M:%S %Z %Y");
+            return kDateFormat.Parse(text, timestamp);
+        }
+        return false;
+    }
+
+    //! \brief Append a timestamp to a string as an ISO 8601 date time in UTC, YYYY-MM-DD HH:MM:SS.
+    inline void AppendTimestamp(const Timestamp &timestamp, std::string &out) {
+        auto days = timestamp.seconds / 86400, seconds = timestamp.seconds % 86400;
+        if (seconds < 0) {
+            seconds += 86400;
+            --days;
+        }
+        std::int64_t year;
+        int month, day;
+        detail::CivilFromDays(days, year, month, day);
+        auto append_digits = [&out](std::int64_t value, int width) {
+            char buffer[24];
+            int size = 0;
+            for (; value != 0 || size < width; value /= 10) {
+                buffer[size++] = static_cast<char>('0' + value % 10);
+            }
+            for (; size > 0; --size) {
+                out += buffer[size - 1];
+            }
+        };
+        if (year < 0) {
+            out += '-';
+            year = -year;
+        }
+        append_digits(year, 4);
+        out += '-';
+        append_digits(month, 2);
+        out += '-';
+        append_digits(day, 2);
+        out += ' ';
+        append_digits(seconds / 3600, 2);
+        out += ':';
+        append_digits(seconds / 60 % 60, 2);
+        out += ':';
+        append_digits(seconds % 60, 2);
+    }
+
+}
+#endif // __TIMESTAMP_H__
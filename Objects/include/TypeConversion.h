@@ -5,15 +5,22 @@
 #ifndef __TYPE_CONVERSION_H__
 #define __TYPE_CONVERSION_H__
 
+#include <string_view>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
 #include "DTypes.h"
 
 namespace dataframe {
 
-    inline bool ValidBool(const std::string &data) {
+    inline bool ValidBool(std::string_view data) {
         return data == "True" || data == "TRUE" || data == "False" || data == "FALSE" || data.empty();
     }
 
-    inline char ToBool(const std::string &data) {
+    inline char ToBool(std::string_view data) {
         if (data == "True" || data == "TRUE") {
             return true;
         }
@@ -23,135 +30,431 @@ namespace dataframe {
         return -1;
     }
 
-    inline bool ValidInteger(const std::string &data) {
-        return (data.size() == 1 && isdigit(data[0]))
-               || (((1 < data.size() && (data[0] == '+' || data[0] == '-')) || isdigit(data[0]))
-                   && std::find_if(data.begin() + 1, data.end(), [](char c) { return !isdigit(c); }) == data.end());
-    }
+    // ============================================
+    //  Single pass parsing of fields.
+    // ============================================
 
-    inline int ToInteger(const std::string &data) {
-        return static_cast<int>(strtol(data.c_str(), nullptr, 10));
-    }
+    //! \brief The result of classifying and converting a field in a single scan.
+    struct ParsedField {
+        //! \brief The dtype of the field. This is the dtype that CheckDType reports for the field.
+        DType dtype = DType::Empty;
 
-    inline bool ValidDouble(const std::string &data) {
-        if (data.empty()) {
-            return true; // NaN is a valid double.
-        }
-        bool postSign = false, postDecimal = false, postNumber = false;
-        for (auto c : data) {
-            if (isdigit(c)) {
-                postSign = true;
-            } else if (c == '.') {
-                if (postDecimal || postNumber) {
-                    return false;
-                }
-                postDecimal = true;
-            } else if (c == 'e' || c == 'E') {
-                if (postNumber) {
-                    return false;
+        //! \brief The value of the field, if it is an integer, or its seconds since the epoch, if it is a timestamp.
+        long long integer = 0;
+
+        //! \brief The value of the field, if it is an integer or a double.
+        double floating = 0.;
+
+        //! \brief The value of the field, if it is a bool.
+        bool boolean = false;
+    };
+
+    namespace detail {
+        //! \brief Powers of ten that are exactly representable as doubles.
+        constexpr double kExactPowersOfTen[] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        //! \brief Locale independent check for an ascii digit.
+        inline bool IsDigit(char c) {
+            return static_cast<unsigned char>(c - '0') < 10;
+        }
+
+        //! \brief Read eight bytes as a (little endian) 64 bit word.
+        inline uint64_t LoadEight(const char *ptr) {
+            uint64_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            return word;
+        }
+
+        //! \brief Check whether all eight bytes in a word are ascii digits. Every byte of a digit is 0x30 - 0x39, so
+        //! its high nibble is 3, and adding 6 to it does not carry into the high nibble.
+        inline bool IsEightDigits(uint64_t word) {
+            return ((word & 0xF0F0F0F0F0F0F0F0) | (((word + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+                   == 0x3333333333333333;
+        }
+
+        //! \brief Convert eight ascii digits, loaded little endian, to their value, by combining pairs of digits,
+        //! then pairs of pairs, then pairs of quadruples.
+        inline uint32_t ParseEightDigits(uint64_t word) {
+            word = ((word & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+            word = ((word & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+            return static_cast<uint32_t>(((word & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+        }
+
+        //! \brief Consume a run of digits starting at data[i], accumulating them into value. Returns the number of
+        //! digits. Digits past the 19th are counted, but not accumulated, since they could overflow.
+        inline std::size_t ConsumeDigits(std::string_view data, std::size_t &i, uint64_t &value, std::size_t &num_digits) {
+            std::size_t start = i;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            while (i + 8 <= data.size() && num_digits + 8 <= 19) {
+                auto word = LoadEight(data.data() + i);
+                if (!IsEightDigits(word)) {
+                    break;
                 }
-                postNumber = true;
-                postSign = false; // The exponent can have a sign.
-            } else if (c == '+' || c == '-') {
-                if (postSign) {
-                    return false;
+                value = value * 100000000 + ParseEightDigits(word);
+                num_digits += 8;
+                i += 8;
+            }
+#endif
+            for (; i < data.size() && IsDigit(data[i]); ++i, ++num_digits) {
+                if (num_digits < 19) {
+                    value = 10 * value + (data[i] - '0');
                 }
-                postSign = true;
-            } else {
-                return false;
             }
+            return i - start;
+        }
+
+        //! \brief Correctly rounded conversion for the rare numbers that cannot be converted exactly. strtod needs a
+        //! null terminated string, so short fields are copied to the stack instead of the heap.
+        inline double SlowToDouble(std::string_view data) {
+            char buffer[64];
+            if (data.size() < sizeof(buffer)) {
+                std::copy(data.begin(), data.end(), buffer);
+                buffer[data.size()] = '\0';
+                return strtod(buffer, nullptr);
+            }
+            return strtod(std::string(data).c_str(), nullptr);
         }
-        return true;
-    }
 
-    inline double ToDouble(const std::string &data) {
-        return atof(data.c_str());
+        //! \brief Classify a field that is not a number or a bool. It is a Timestamp if it is in one of the formats
+        //! that timestamps are inferred from, and a String otherwise.
+        inline ParsedField ParseText(std::string_view data) {
+            ParsedField field;
+            Timestamp timestamp;
+            if (InferTimestamp(data, timestamp)) {
+                field.dtype = DType::Timestamp;
+                field.integer = timestamp.seconds;
+            }
+            else {
+                field.dtype = DType::String;
+            }
+            return field;
+        }
     }
 
-    inline DType CheckDType(const std::string &data) {
-        // This is a NaN value_.
+    //! \brief Classify a field and convert it to its value in a single scan over the characters.
+    //!
+    //! Numbers have the form [+-]digits[.digits][(e|E)[+-]digits], with at least one digit before the exponent. A
+    //! number without a decimal point or exponent is an Integer if it fits in an int, and an Int64 if not. Bools are True, TRUE, False, or FALSE. An empty field
+    //! is Empty. Anything else is a Timestamp if InferTimestamp accepts it, and a String if not. Parsing is locale
+    //! independent.
+    inline ParsedField ParseField(std::string_view data) {
+        ParsedField field;
         if (data.empty()) {
-            return DType::Empty;
+            return field;
         }
-
-        // Check if data is a bool
         if (ValidBool(data)) {
-            return DType::Bool;
+            field.dtype = DType::Bool;
+            field.boolean = ToBool(data) == 1;
+            return field;
         }
-        // Check if data is an integer.
-        if (ValidInteger(data)) {
-            return DType::Integer;
+
+        std::size_t i = 0;
+        bool negative = false;
+        if (data[i] == '+' || data[i] == '-') {
+            negative = data[i] == '-';
+            ++i;
+        }
+        // Leading zeros do not count against the precision of the mantissa.
+        std::size_t leading_zeros = 0;
+        for (; i < data.size() && data[i] == '0'; ++i, ++leading_zeros);
+        uint64_t mantissa = 0;
+        std::size_t num_digits = 0;
+        auto int_digits = leading_zeros + detail::ConsumeDigits(data, i, mantissa, num_digits);
+
+        std::size_t frac_digits = 0;
+        bool is_integer = true;
+        if (i < data.size() && data[i] == '.') {
+            ++i;
+            is_integer = false;
+            frac_digits = detail::ConsumeDigits(data, i, mantissa, num_digits);
         }
-        // Check if data is a double. Integers are valid doubles too.
-        if (ValidDouble(data)) {
-            return DType::Double;
+        if (int_digits + frac_digits == 0) {
+            return detail::ParseText(data);
         }
 
-        // Otherwise, data must be a string.
-        return DType::String;
+        long exponent = 0;
+        if (i < data.size() && (data[i] == 'e' || data[i] == 'E')) {
+            ++i;
+            is_integer = false;
+            bool negative_exponent = false;
+            if (i < data.size() && (data[i] == '+' || data[i] == '-')) {
+                negative_exponent = data[i] == '-';
+                ++i;
+            }
+            std::size_t start = i;
+            for (; i < data.size() && detail::IsDigit(data[i]); ++i) {
+                if (exponent < 100000) {
+                    exponent = 10 * exponent + (data[i] - '0');
+                }
+            }
+            if (i == start) {
+                return detail::ParseText(data);
+            }
+            exponent = negative_exponent ? -exponent : exponent;
+        }
+        if (i != data.size()) {
+            return detail::ParseText(data);
+        }
+
+        if (is_integer && (num_digits <= 18
+                           || (num_digits == 19 && mantissa <= uint64_t(std::numeric_limits<long long>::max())))) {
+            field.integer = negative ? -static_cast<long long>(mantissa) : static_cast<long long>(mantissa);
+            field.floating = static_cast<double>(field.integer);
+            // Integers that do not fit in an int are Int64s.
+            field.dtype = std::numeric_limits<int>::min() <= field.integer && field.integer <= std::numeric_limits<int>::max()
+                          ? DType::Integer : DType::Int64;
+            return field;
+        }
+
+        // Integers too large for a long long are stored as doubles.
+        field.dtype = DType::Double;
+        // If the mantissa and the power of ten are both exact doubles, a single multiplication or division is
+        // correctly rounded. Otherwise, fall back on strtod.
+        exponent -= static_cast<long>(frac_digits);
+        if (num_digits <= 19 && mantissa <= (uint64_t(1) << 53) && -22 <= exponent && exponent <= 22) {
+            auto value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / detail::kExactPowersOfTen[-exponent]
+                                 : value * detail::kExactPowersOfTen[exponent];
+            field.floating = negative ? -value : value;
+        }
+        else {
+            field.floating = detail::SlowToDouble(data);
+        }
+        return field;
     }
 
-    inline bool RecheckDType(const std::string &data, DType dtype) {
+    inline bool ValidInteger(std::string_view data) {
+        return ParseField(data).dtype == DType::Integer;
+    }
+
+    inline int ToInteger(std::string_view data) {
+        return static_cast<int>(ParseField(data).integer);
+    }
+
+    inline bool ValidDouble(std::string_view data) {
+        auto dtype = ParseField(data).dtype;
+        // NaN is a valid double, and integers are valid doubles too.
+        return dtype == DType::Empty || IsIntegerDType(dtype) || dtype == DType::Double;
+    }
+
+    inline double ToDouble(std::string_view data) {
+        return ParseField(data).floating;
+    }
+
+    inline DType CheckDType(std::string_view data) {
+        return ParseField(data).dtype;
+    }
+
+    //! \brief Check whether a field that has already been classified can be stored in a column of type dtype.
+    inline bool RecheckDType(DType field_dtype, DType dtype) {
         switch (dtype) {
             case DType::Double:
             case DType::Float:
-                return ValidDouble(data);
+                // NaN is a valid double, and integers are valid doubles too.
+                return field_dtype == DType::Empty || IsIntegerDType(field_dtype) || field_dtype == DType::Double;
             case DType::String:
+            case DType::Categorical:
                 // Anything is a valid string.
                 return true;
             case DType::Bool:
-                return ValidBool(data);
+                return field_dtype == DType::Bool || field_dtype == DType::Empty;
             case DType::Integer:
-                return ValidInteger(data);
+                // Empty fields are stored as nulls.
+                return field_dtype == DType::Integer || field_dtype == DType::Empty;
+            case DType::Int8:
+            case DType::Int16:
+            case DType::Int64:
+            case DType::UInt8:
+            case DType::UInt16:
+            case DType::UInt32:
+            case DType::UInt64:
+                // Integers that are out of range are stored as nulls.
+                return IsIntegerDType(field_dtype) || field_dtype == DType::Empty;
+            case DType::Timestamp:
+                return field_dtype == DType::Timestamp || field_dtype == DType::Empty;
             default:
             case DType::Other:
                 // Only a valid Other if it can't be anything else.
-                return CheckDType(data) == DType::Other;
+                return field_dtype == DType::Other;
         }
     }
 
+    inline bool RecheckDType(std::string_view data, DType dtype) {
+        return RecheckDType(ParseField(data).dtype, dtype);
+    }
+
     // ============================================
     //  Type conversion from string
     // ============================================
 
     template<typename T>
-    inline T ToType(const std::string &data) {
-        return T();
+    inline T ToType(std::string_view data) {
+        if constexpr (std::is_integral<T>::value) {
+            return static_cast<T>(ParseField(data).integer);
+        }
+        else {
+            return T();
+        }
     }
 
     template<>
-    inline NoneDType ToType<NoneDType>(const std::string &data) {
+    inline NoneDType ToType<NoneDType>(std::string_view data) {
         return {};
     }
 
     template<>
-    inline EmptyDType ToType<EmptyDType>(const std::string &data) {
+    inline EmptyDType ToType<EmptyDType>(std::string_view data) {
         return {};
     }
 
     template<>
-    inline double ToType<double>(const std::string &data) {
+    inline double ToType<double>(std::string_view data) {
         return ToDouble(data);
     }
 
     template<>
-    inline float ToType<float>(const std::string &data) {
+    inline float ToType<float>(std::string_view data) {
         return static_cast<float>(ToDouble(data));
     }
 
     template<>
-    inline int ToType<int>(const std::string &data) {
+    inline int ToType<int>(std::string_view data) {
         return ToInteger(data);
     }
 
     template<>
-    inline char ToType<char>(const std::string &data) {
+    inline char ToType<char>(std::string_view data) {
         return ToBool(data);
     }
 
     template<>
-    inline std::string ToType<std::string>(const std::string &data) {
-        return data;
+    inline bool ToType<bool>(std::string_view data) {
+        return ToBool(data) == 1;
+    }
+
+    template<>
+    inline std::string ToType<std::string>(std::string_view data) {
+        return std::string(data);
+    }
+
+    //! \brief The Categorical is a view of the data. It is copied when it is added to a column.
+    template<>
+    inline Categorical ToType<Categorical>(std::string_view data) {
+        return Categorical(data);
+    }
+
+    //! \brief Timestamps are read in any of the inferred formats. Anything else is the epoch.
+    template<>
+    inline Timestamp ToType<Timestamp>(std::string_view data) {
+        Timestamp timestamp;
+        InferTimestamp(data, timestamp);
+        return timestamp;
+    }
+
+    // ============================================
+    //  Type conversion from parsed fields
+    // ============================================
+
+    //! \brief Get the value of a field that was already parsed by ParseField, without scanning it again. The data is
+    //! the text of the field, for types whose value is the text itself.
+    template<typename T>
+    inline T FromParsed(const ParsedField &field, std::string_view data) {
+        if constexpr (std::is_integral<T>::value) {
+            return static_cast<T>(field.integer);
+        }
+        else {
+            return ToType<T>(data);
+        }
+    }
+
+    template<>
+    inline int FromParsed<int>(const ParsedField &field, std::string_view data) {
+        return static_cast<int>(field.integer);
+    }
+
+    template<>
+    inline double FromParsed<double>(const ParsedField &field, std::string_view data) {
+        return IsIntegerDType(field.dtype) || field.dtype == DType::Double
+               ? field.floating : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    template<>
+    inline float FromParsed<float>(const ParsedField &field, std::string_view data) {
+        return IsIntegerDType(field.dtype) || field.dtype == DType::Double
+               ? static_cast<float>(field.floating) : std::numeric_limits<float>::quiet_NaN();
+    }
+
+    template<>
+    inline std::string FromParsed<std::string>(const ParsedField &field, std::string_view data) {
+        return std::string(data);
+    }
+
+    template<>
+    inline bool FromParsed<bool>(const ParsedField &field, std::string_view data) {
+        return field.boolean;
+    }
+
+    template<>
+    inline Timestamp FromParsed<Timestamp>(const ParsedField &field, std::string_view data) {
+        return Timestamp{field.integer};
+    }
+
+    namespace detail {
+        //! \brief Whether an integer can be stored in an integer type T without changing its value.
+        template<typename T>
+        inline bool InRange(long long value) {
+            if constexpr (std::is_unsigned<T>::value) {
+                return 0 <= value && static_cast<unsigned long long>(value) <= std::numeric_limits<T>::max();
+            }
+            else {
+                return std::numeric_limits<T>::min() <= value && value <= std::numeric_limits<T>::max();
+            }
+        }
+    }
+
+    //! \brief Check whether a field that was already parsed by ParseField holds a value of type T. If it does not, the
+    //! field is stored as a null. Integers that are out of the range of an integer type are not values of the type.
+    template<typename T>
+    inline bool IsValidParsed(const ParsedField &field) {
+        if constexpr (std::is_integral<T>::value) {
+            return IsIntegerDType(field.dtype) && detail::InRange<T>(field.integer);
+        }
+        else {
+            return field.dtype != DType::Empty;
+        }
+    }
+
+    template<>
+    inline bool IsValidParsed<NoneDType>(const ParsedField &field) {
+        return false;
+    }
+
+    template<>
+    inline bool IsValidParsed<EmptyDType>(const ParsedField &field) {
+        return false;
+    }
+
+    template<>
+    inline bool IsValidParsed<double>(const ParsedField &field) {
+        return IsIntegerDType(field.dtype) || field.dtype == DType::Double;
+    }
+
+    template<>
+    inline bool IsValidParsed<float>(const ParsedField &field) {
+        return IsIntegerDType(field.dtype) || field.dtype == DType::Double;
+    }
+
+    template<>
+    inline bool IsValidParsed<bool>(const ParsedField &field) {
+        return field.dtype == DType::Bool;
+    }
+
+    template<>
+    inline bool IsValidParsed<Timestamp>(const ParsedField &field) {
+        return field.dtype == DType::Timestamp;
     }
 
     // ============================================
@@ -195,19 +498,130 @@ namespace dataframe {
             case DType::None:
                 return true;
             case DType::Empty:
-                return finalT != DType::None && finalT != DType::Integer;
+                return finalT != DType::None;
             case DType::Bool:
                 return finalT != DType::Other;
             case DType::Integer:
+            case DType::Int8:
+            case DType::Int16:
+            case DType::Int64:
+            case DType::UInt8:
+            case DType::UInt16:
+            case DType::UInt32:
+            case DType::UInt64:
                 return finalT != DType::None && finalT != DType::Empty && finalT != DType::Bool;
             case DType::Float:
             case DType::Double:
                 return finalT == DType::Float || finalT == DType::String;
-            default:
             case DType::String:
+                return finalT == DType::Categorical;
+            case DType::Categorical:
+            case DType::Timestamp:
+                return finalT == DType::String;
+            default:
                 return false;
         }
     }
 
+    namespace detail {
+        //! \brief The width, in bytes, of an integer dtype.
+        inline std::size_t IntegerWidth(DType dtype) {
+            switch (dtype) {
+                case DType::Int8:
+                case DType::UInt8:
+                    return 1;
+                case DType::Int16:
+                case DType::UInt16:
+                    return 2;
+                case DType::Int64:
+                case DType::UInt64:
+                    return 8;
+                default:
+                    return 4;
+            }
+        }
+
+        inline bool IsUnsignedDType(DType dtype) {
+            return dtype == DType::UInt8 || dtype == DType::UInt16 || dtype == DType::UInt32 || dtype == DType::UInt64;
+        }
+
+        //! \brief The integer dtype with a width, in bytes, and signedness.
+        inline DType IntegerDType(std::size_t width, bool is_signed) {
+            switch (width) {
+                case 1:
+                    return is_signed ? DType::Int8 : DType::UInt8;
+                case 2:
+                    return is_signed ? DType::Int16 : DType::UInt16;
+                case 4:
+                    return is_signed ? DType::Integer : DType::UInt32;
+                default:
+                    return is_signed ? DType::Int64 : DType::UInt64;
+            }
+        }
+
+        //! \brief The narrowest integer dtype that holds the values of two integer dtypes. A signed dtype has to be
+        //! twice as wide as an unsigned dtype to hold its values, which is not possible for UInt64.
+        inline DType CommonIntegerDType(DType a, DType b) {
+            auto width_a = IntegerWidth(a), width_b = IntegerWidth(b);
+            if (IsUnsignedDType(a) == IsUnsignedDType(b)) {
+                return width_a < width_b ? b : a;
+            }
+            auto signed_width = IsUnsignedDType(a) ? width_b : width_a;
+            auto unsigned_width = IsUnsignedDType(a) ? width_a : width_b;
+            return IntegerDType(std::min<std::size_t>(8, std::max(signed_width, 2 * unsigned_width)), true);
+        }
+    }
+
+    //! \brief The narrowest integer dtype that holds every integer from min to max. Unsigned dtypes are only used if
+    //! they are narrower than the signed dtype that would be needed.
+    inline DType NarrowestIntegerDType(long long min, long long max) {
+        for (std::size_t width = 1; width < 8; width *= 2) {
+            auto bits = 8 * width;
+            if (-(1ll << (bits - 1)) <= min && max < (1ll << (bits - 1))) {
+                return detail::IntegerDType(width, true);
+            }
+            if (0 <= min && max < (1ll << bits)) {
+                return detail::IntegerDType(width, false);
+            }
+        }
+        return DType::Int64;
+    }
+
+    //! \brief Find the dtype that a column must have to hold data of both dtypes, e.g. when pieces of a column
+    //! had their dtypes inferred separately. This follows the same conversions that are made when the dtype of a
+    //! column is inferred serially. Returns DType::Other if no such dtype exists.
+    inline DType CommonDType(DType a, DType b) {
+        if (a == b || b == DType::None) {
+            return a;
+        }
+        if (a == DType::None) {
+            return b;
+        }
+        if (a == DType::Other || b == DType::Other) {
+            return DType::Other;
+        }
+        if (a == DType::String || b == DType::String || a == DType::Categorical || b == DType::Categorical) {
+            return DType::String;
+        }
+        if (a == DType::Empty || b == DType::Empty) {
+            auto other = a == DType::Empty ? b : a;
+            return CanConvert(DType::Empty, other) ? other : DType::Other;
+        }
+        // Timestamps mixed with anything else can only be held as strings.
+        if (a == DType::Timestamp || b == DType::Timestamp) {
+            return DType::String;
+        }
+        if (IsIntegerDType(a) && IsIntegerDType(b)) {
+            return detail::CommonIntegerDType(a, b);
+        }
+        // Integers and floating point values combine into the floating point type.
+        if ((IsIntegerDType(a) || a == DType::Float || a == DType::Double)
+            && (IsIntegerDType(b) || b == DType::Float || b == DType::Double)) {
+            return (a == DType::Double || b == DType::Double) ? DType::Double : DType::Float;
+        }
+        // Bools cannot be combined with numbers.
+        return DType::Other;
+    }
+
 }
 #endif // __TYPE_CONVERSION_H__
@@ -0,0 +1,221 @@
+//
+// Created by Nathaniel Rupprecht on 5/23/21.
+//
+
+#ifndef __VALIDITY_H__
+#define __VALIDITY_H__
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "IndexMap.h"
+
+namespace dataframe {
+
+    //! \brief Records which entries of a column are valid (not null), one bit per entry, like an Arrow validity
+    //! bitmap.
+    //!
+    //! The bits are only allocated once an entry is null, so a column without nulls costs nothing, and checks against
+    //! it reduce to a single comparison. Once allocated, entry i is bit (i % 64) of word (i / 64), a set bit means the
+    //! entry is valid, and the bits past the last entry are zero, so nulls can be counted a word at a time.
+    class ValidityBitmap {
+    public:
+        ValidityBitmap() = default;
+
+        // ========================================
+        //  Accessors.
+        // ========================================
+
+        //! \brief The number of entries.
+        std::size_t Size() const { return size_; }
+
+        //! \brief The number of null entries.
+        std::size_t NullCount() const { return null_count_; }
+
+        //! \brief Whether every entry is valid.
+        bool AllValid() const { return null_count_ == 0; }
+
+        //! \brief Whether an entry is valid.
+        bool IsValid(std::size_t index) const {
+            return words_.empty() || ((words_[index >> 6] >> (index & 63)) & 1);
+        }
+
+        //! \brief The words of the bitmap. This is empty if no bits have been allocated, in which case every entry is
+        //! valid.
+        const std::vector<std::uint64_t> &Words() const { return words_; }
+
+        // ========================================
+        //  Modifiers.
+        // ========================================
+
+        //! \brief Add an entry.
+        void PushBack(bool valid) {
+            if (!valid || !words_.empty()) {
+                if (words_.empty()) {
+                    Materialize();
+                }
+                if ((size_ & 63) == 0) {
+                    words_.push_back(0);
+                }
+                words_.back() |= static_cast<std::uint64_t>(valid) << (size_ & 63);
+            }
+            null_count_ += !valid;
+            ++size_;
+        }
+
+        //! \brief Set whether an entry is valid.
+        void Set(std::size_t index, bool valid) {
+            if (IsValid(index) == valid) {
+                return;
+            }
+            if (words_.empty()) {
+                Materialize();
+            }
+            words_[index >> 6] ^= std::uint64_t(1) << (index & 63);
+            valid ? --null_count_ : ++null_count_;
+        }
+
+        //! \brief Add the entries of another bitmap after the entries of this one.
+        void Append(const ValidityBitmap &other) {
+            if (&other == this) {
+                ValidityBitmap copy(other);
+                Append(copy);
+                return;
+            }
+            if (AllValid() && other.AllValid()) {
+                words_.clear();
+                size_ += other.size_;
+                return;
+            }
+            if (words_.empty()) {
+                Materialize();
+            }
+            auto shift = size_ & 63;
+            words_.resize(WordsFor(size_ + other.size_), 0);
+            for (std::size_t w = 0; w < WordsFor(other.size_); ++w) {
+                auto word = other.words_.empty() ? LastWordMask(other.size_, w) : other.words_[w];
+                auto index = (size_ >> 6) + w;
+                words_[index] |= word << shift;
+                if (shift != 0 && index + 1 < words_.size()) {
+                    words_[index + 1] |= word >> (64 - shift);
+                }
+            }
+            size_ += other.size_;
+            null_count_ += other.null_count_;
+        }
+
+        //! \brief Make the bitmap have size entries. Entries that are added are valid or null, as specified.
+        void Resize(std::size_t size, bool valid = true) {
+            if (size < size_) {
+                if (!words_.empty()) {
+                    words_.resize(WordsFor(size));
+                    if (size & 63) {
+                        words_.back() &= (std::uint64_t(1) << (size & 63)) - 1;
+                    }
+                }
+                size_ = size;
+                null_count_ = words_.empty() ? 0 : CountNulls();
+                return;
+            }
+            while (size_ < size) {
+                PushBack(valid);
+            }
+        }
+
+        //! \brief Make the bitmap have size entries, all of which are valid, or all of which are null.
+        void Reset(std::size_t size = 0, bool valid = true) {
+            words_.clear();
+            size_ = size;
+            null_count_ = 0;
+            if (!valid && size) {
+                words_.resize(WordsFor(size), 0);
+                null_count_ = size;
+            }
+        }
+
+        //! \brief Reserve space for a number of entries.
+        void Reserve(std::size_t size) {
+            if (!words_.empty()) {
+                words_.reserve(WordsFor(size));
+            }
+        }
+
+        //! \brief Replace the bitmap with size entries whose words are stored (possibly unaligned) at data. If data is
+        //! null, every entry is valid.
+        void Assign(const char *data, std::size_t size) {
+            Reset(size);
+            if (data && size) {
+                words_.resize(WordsFor(size));
+                std::memcpy(words_.data(), data, words_.size() * sizeof(std::uint64_t));
+                if (size & 63) {
+                    words_.back() &= (std::uint64_t(1) << (size & 63)) - 1;
+                }
+                null_count_ = CountNulls();
+                if (null_count_ == 0) {
+                    words_.clear();
+                }
+            }
+        }
+
+        //! \brief Create a bitmap whose entries are the entries of this bitmap that a (non-full) index map selects.
+        ValidityBitmap Gather(const IndexMap &index_map) const {
+            ValidityBitmap output;
+            const auto size = index_map.Size(size_);
+            if (AllValid()) {
+                output.size_ = size;
+                return output;
+            }
+            output.words_.resize(WordsFor(size), 0);
+            std::size_t i = 0;
+            index_map.ForEach(size, [&](std::size_t index) {
+                output.words_[i >> 6] |= static_cast<std::uint64_t>(IsValid(index)) << (i & 63);
+                ++i;
+            });
+            output.size_ = size;
+            output.null_count_ = output.CountNulls();
+            if (output.null_count_ == 0) {
+                output.words_.clear();
+            }
+            return output;
+        }
+
+        //! \brief The number of words needed for a number of entries.
+        static std::size_t WordsFor(std::size_t size) { return (size + 63) >> 6; }
+
+    private:
+        //! \brief Allocate the bits, with every current entry valid.
+        void Materialize() {
+            words_.assign(WordsFor(size_), ~std::uint64_t(0));
+            if (size_ & 63) {
+                words_.back() = (std::uint64_t(1) << (size_ & 63)) - 1;
+            }
+        }
+
+        //! \brief The w-th word of an all valid bitmap with size entries.
+        static std::uint64_t LastWordMask(std::size_t size, std::size_t w) {
+            auto remaining = size - 64 * w;
+            return remaining >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << remaining) - 1;
+        }
+
+        //! \brief Count the null entries, a word at a time.
+        std::size_t CountNulls() const {
+            std::size_t valid = 0;
+            for (auto word : words_) {
+                valid += static_cast<std::size_t>(__builtin_popcountll(word));
+            }
+            return size_ - valid;
+        }
+
+        //! \brief The bits, or nothing if every entry is valid.
+        std::vector<std::uint64_t> words_;
+
+        //! \brief The number of entries.
+        std::size_t size_ = 0;
+
+        //! \brief The number of null entries.
+        std::size_t null_count_ = 0;
+    };
+
+}
+#endif // __VALIDITY_H__
@@ -19,17 +19,171 @@ struct DataFrame::Column::Box {
         return Box(wrapper_->Clone());
     }
 
+    //! \brief Return a box that shares this box's wrapper. The wrapper is only copied when one of the boxes sharing it
+    //! is written to. If something other than a box, like a concrete column, holds the wrapper, it can write to the
+    //! wrapper directly, so the wrapper is copied right away instead.
+    Box Share() const {
+        if (wrapper_.use_count() > owners_.use_count()) {
+            return Box(wrapper_->Clone());
+        }
+        return *this;
+    }
+
+    //! \brief Whether other boxes share this box's wrapper.
+    bool IsShared() const {
+        return owners_.use_count() > 1;
+    }
+
+    //! \brief Make sure that no other box shares the wrapper, copying the wrapper if one does. This must be called
+    //! before the wrapper is written to.
+    void Own() {
+        if (IsShared()) {
+            wrapper_ = wrapper_->Clone();
+            owners_ = std::make_shared<char>();
+        }
+    }
+
+    //! \brief Coalesce the wrapper's chunks. A shared wrapper is copied instead of being changed in place.
+    void Compact() {
+        if (wrapper_->NumChunks() > 1) {
+            Own();
+            wrapper_->Compact();
+        }
+    }
+
+    //! \brief Replace the wrapper with another box's wrapper, sharing it with that box.
+    void ShareWith(const Box& box) {
+        auto shared = box.Share();
+        SetWrapper(std::move(shared.wrapper_));
+        owners_ = std::move(shared.owners_);
+    }
+
     void SetWrapper(std::shared_ptr<Wrapper>&& ptr) {
-        if (wrapper_) {
+        // A wrapper that other boxes still share has not been orphaned.
+        if (wrapper_ && !IsShared()) {
             wrapper_->is_orphan = true;
         }
         wrapper_ = std::move(ptr);
+        owners_ = std::make_shared<char>();
+    }
+
+    //! \brief Create a wrapper of a dtype with size entries, all of which are null. Returns null for DType::Other.
+    static std::shared_ptr<Wrapper> MakeNullWrapper(DType dtype, std::size_t size) {
+        std::shared_ptr<Wrapper> wrapper;
+        switch (dtype) {
+            case DType::None:
+                wrapper = std::make_shared<ConcreteWrapper<NoneDType>>(size);
+                break;
+            case DType::Empty:
+                wrapper = std::make_shared<ConcreteWrapper<EmptyDType>>(size);
+                break;
+            case DType::Integer:
+                wrapper = std::make_shared<ConcreteWrapper<int>>(size, NullValue<int>::value());
+                break;
+            case DType::Float:
+                wrapper = std::make_shared<ConcreteWrapper<float>>(size, NullValue<float>::value());
+                break;
+            case DType::Double:
+                wrapper = std::make_shared<ConcreteWrapper<double>>(size, NullValue<double>::value());
+                break;
+            case DType::Bool:
+                wrapper = std::make_shared<ConcreteWrapper<bool>>(size, NullValue<bool>::value());
+                break;
+            case DType::String:
+                wrapper = std::make_shared<ConcreteWrapper<std::string>>(size, NullValue<std::string>::value());
+                break;
+            case DType::Categorical:
+                wrapper = std::make_shared<ConcreteWrapper<Categorical>>(size, NullValue<Categorical>::value());
+                break;
+            case DType::Timestamp:
+                wrapper = std::make_shared<ConcreteWrapper<Timestamp>>(size, NullValue<Timestamp>::value());
+                break;
+            case DType::Int8:
+                wrapper = std::make_shared<ConcreteWrapper<std::int8_t>>(size, NullValue<std::int8_t>::value());
+                break;
+            case DType::Int16:
+                wrapper = std::make_shared<ConcreteWrapper<std::int16_t>>(size, NullValue<std::int16_t>::value());
+                break;
+            case DType::Int64:
+                wrapper = std::make_shared<ConcreteWrapper<std::int64_t>>(size, NullValue<std::int64_t>::value());
+                break;
+            case DType::UInt8:
+                wrapper = std::make_shared<ConcreteWrapper<std::uint8_t>>(size, NullValue<std::uint8_t>::value());
+                break;
+            case DType::UInt16:
+                wrapper = std::make_shared<ConcreteWrapper<std::uint16_t>>(size, NullValue<std::uint16_t>::value());
+                break;
+            case DType::UInt32:
+                wrapper = std::make_shared<ConcreteWrapper<std::uint32_t>>(size, NullValue<std::uint32_t>::value());
+                break;
+            case DType::UInt64:
+                wrapper = std::make_shared<ConcreteWrapper<std::uint64_t>>(size, NullValue<std::uint64_t>::value());
+                break;
+            default:
+                return nullptr;
+        }
+        wrapper->validity.Reset(size, false);
+        return wrapper;
+    }
+
+    //! \brief If the wrapper holds integers, of any width, call the function with the wrapper, cast to its concrete
+    //! type. Returns false if the wrapper does not hold integers.
+    template<typename Function>
+    bool VisitIntegers(DType old_wrapper_type, Function&& function) {
+        switch (old_wrapper_type) {
+            case DType::Integer:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<int>>(wrapper_));
+                return true;
+            case DType::Int8:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::int8_t>>(wrapper_));
+                return true;
+            case DType::Int16:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::int16_t>>(wrapper_));
+                return true;
+            case DType::Int64:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::int64_t>>(wrapper_));
+                return true;
+            case DType::UInt8:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::uint8_t>>(wrapper_));
+                return true;
+            case DType::UInt16:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::uint16_t>>(wrapper_));
+                return true;
+            case DType::UInt32:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::uint32_t>>(wrapper_));
+                return true;
+            case DType::UInt64:
+                function(util::reinterpret_pointer_cast<ConcreteWrapper<std::uint64_t>>(wrapper_));
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    //! \brief If the wrapper holds integers, of any width, copy them into a new wrapper of type T. Returns false if the
+    //! wrapper does not hold integers.
+    template<typename T>
+    bool CastIntegers(const std::shared_ptr<DataFrame::Column::ConcreteWrapper<T>>& new_wrapper, DType old_wrapper_type) {
+        return VisitIntegers(old_wrapper_type, [&new_wrapper] (const auto& ptr) {
+            std::size_t sz = ptr->data_.size();
+            new_wrapper->data_.resize(sz);
+            for (std::size_t i = 0; i < sz; ++i) {
+                new_wrapper->data_[i] = static_cast<T>(std::as_const(ptr->data_)[i]);
+            }
+        });
     }
 
+    //! \brief Integers of any width can be converted to integers of any other width. It is up to the caller to make sure
+    //! the values are in range.
     template<typename T>
     bool TryConvert(
             const std::shared_ptr<DataFrame::Column::ConcreteWrapper<T>>& new_wrapper,
             DType old_wrapper_type) {
+        if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value) {
+            if (CastIntegers(new_wrapper, old_wrapper_type)) {
+                return true;
+            }
+        }
         return old_wrapper_type == DType::None;
     }
 
@@ -38,25 +192,20 @@ struct DataFrame::Column::Box {
             const std::shared_ptr<DataFrame::Column::ConcreteWrapper<double>>& new_wrapper,
             DType old_wrapper_type)
     {
+        if (CastIntegers(new_wrapper, old_wrapper_type)) {
+            return true;
+        }
         std::size_t sz = wrapper_->Size();
         switch (old_wrapper_type) {
-            case DType::Integer: {
-                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<int>>(wrapper_);
-                new_wrapper->data_.resize(sz);
-                for (std::size_t i = 0; i < sz; ++i) {
-                    new_wrapper->data_[i] = static_cast<double>(ptr->data_[i]);
-                }
-                return true;
-            }
             case DType::Float: {
                 auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<float>>(wrapper_);
                 new_wrapper->data_.resize(sz);
                 for (std::size_t i = 0; i < sz; ++i) {
-                    if (IsNaN<float>::check(ptr->data_[i])) {
+                    if (IsNaN<float>::check(std::as_const(ptr->data_)[i])) {
                         new_wrapper->data_[i] = std::numeric_limits<double>::quiet_NaN();
                     }
                     else {
-                        new_wrapper->data_[i] = static_cast<double>(ptr->data_[i]);
+                        new_wrapper->data_[i] = static_cast<double>(std::as_const(ptr->data_)[i]);
                     }
                 }
                 return true;
@@ -74,25 +223,20 @@ struct DataFrame::Column::Box {
             const std::shared_ptr<DataFrame::Column::ConcreteWrapper<float>>& new_wrapper,
             DType old_wrapper_type)
     {
+        if (CastIntegers(new_wrapper, old_wrapper_type)) {
+            return true;
+        }
         std::size_t sz = wrapper_->Size();
         switch (old_wrapper_type) {
-            case DType::Integer: {
-                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<int>>(wrapper_);
-                new_wrapper->data_.resize(sz);
-                for (std::size_t i = 0; i < sz; ++i) {
-                    new_wrapper->data_[i] = static_cast<float>(ptr->data_[i]);
-                }
-                return true;
-            }
             case DType::Double: {
-                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<float>>(wrapper_);
+                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<double>>(wrapper_);
                 new_wrapper->data_.resize(sz);
                 for (std::size_t i = 0; i < sz; ++i) {
-                    if (IsNaN<double>::check(ptr->data_[i])) {
+                    if (IsNaN<double>::check(std::as_const(ptr->data_)[i])) {
                         new_wrapper->data_[i] = std::numeric_limits<float>::quiet_NaN();
                     }
                     else {
-                        new_wrapper->data_[i] = static_cast<float>(ptr->data_[i]);
+                        new_wrapper->data_[i] = static_cast<float>(std::as_const(ptr->data_)[i]);
                     }
                 }
                 return true;
@@ -111,47 +255,84 @@ struct DataFrame::Column::Box {
             DType old_wrapper_type)
     {
         std::size_t sz = wrapper_->Size();
-        switch (old_wrapper_type) {
-            case DType::Integer: {
-                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<int>>(wrapper_);
-                new_wrapper->data_.resize(sz);
-                for (std::size_t i = 0; i < sz; ++i) {
-                    new_wrapper->data_[i] = std::to_string(ptr->data_[i]);
+        // Integers of any width.
+        bool is_integer = VisitIntegers(old_wrapper_type, [&] (const auto& ptr) {
+            new_wrapper->data_.Reserve(sz);
+            std::string text;
+            for (std::size_t i = 0; i < sz; ++i) {
+                text.clear();
+                if (wrapper_->validity.IsValid(i)) {
+                    detail::AppendNumber(std::as_const(ptr->data_)[i], text);
                 }
-                return true;
+                new_wrapper->data_.push_back(text);
             }
+        });
+        if (is_integer) {
+            return true;
+        }
+        switch (old_wrapper_type) {
             case DType::Double: {
                 auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<double>>(wrapper_);
-                new_wrapper->data_.resize(sz);
+                new_wrapper->data_.Reserve(sz);
                 for (std::size_t i = 0; i < sz; ++i) {
-                    if (IsNaN<double>::check(ptr->data_[i])) {
-                        new_wrapper->data_[i] = std::numeric_limits<float>::quiet_NaN();
+                    if (IsNaN<double>::check(std::as_const(ptr->data_)[i])) {
+                        new_wrapper->data_.push_back("");
                     } else {
-                        new_wrapper->data_[i] = std::to_string(ptr->data_[i]);
+                        new_wrapper->data_.push_back(std::to_string(std::as_const(ptr->data_)[i]));
                     }
                 }
                 return true;
             }
             case DType::Float: {
                 auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<float>> (wrapper_);
-                new_wrapper->data_.resize(sz);
+                new_wrapper->data_.Reserve(sz);
                 for (std::size_t i = 0; i < sz; ++i) {
-                    if (IsNaN<float>::check(ptr->data_[i])) {
-                        new_wrapper->data_[i] = "";
+                    if (IsNaN<float>::check(std::as_const(ptr->data_)[i])) {
+                        new_wrapper->data_.push_back("");
                     } else {
-                        new_wrapper->data_[i] = std::to_string(ptr->data_[i]);
+                        new_wrapper->data_.push_back(std::to_string(std::as_const(ptr->data_)[i]));
                     }
                 }
                 return true;
             }
             case DType::Bool: {
                 auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<bool>>(wrapper_);
-                new_wrapper->data_.resize(sz);
+                new_wrapper->data_.Reserve(sz);
                 for (std::size_t i = 0; i < sz; ++i) {
-                    if (IsNaN<bool>::check(ptr->data_[i])) {
-                        new_wrapper->data_[i] = "";
+                    if (IsNaN<bool>::check(std::as_const(ptr->data_)[i])) {
+                        new_wrapper->data_.push_back("");
                     } else {
-                        new_wrapper->data_[i] = ptr->data_[i] == 0 ? "False" : "True";
+                        new_wrapper->data_.push_back(std::as_const(ptr->data_)[i] == 0 ? "False" : "True");
+                    }
+                }
+                return true;
+            }
+            case DType::Categorical: {
+                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<Categorical>>(wrapper_);
+                const auto& data = ptr->data_;
+                new_wrapper->data_.Reserve(sz);
+                for (std::size_t i = 0; i < sz; ++i) {
+                    new_wrapper->data_.push_back(data[i]);
+                }
+                return true;
+            }
+            case DType::Timestamp: {
+                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<Timestamp>>(wrapper_);
+                const auto& source_text = ptr->source_text_;
+                new_wrapper->data_.Reserve(sz);
+                std::string text;
+                for (std::size_t i = 0; i < sz; ++i) {
+                    text.clear();
+                    if (!wrapper_->validity.IsValid(i)) {
+                        new_wrapper->data_.push_back(text);
+                    }
+                    else if (i < source_text.size() && !source_text[i].empty()) {
+                        // Timestamps that were read from a csv keep the text they were read from.
+                        new_wrapper->data_.push_back(source_text[i]);
+                    }
+                    else {
+                        AppendTimestamp(std::as_const(ptr->data_)[i], text);
+                        new_wrapper->data_.push_back(text);
                     }
                 }
                 return true;
@@ -164,6 +345,30 @@ struct DataFrame::Column::Box {
         }
     }
 
+    template<>
+    bool TryConvert<Categorical>(
+            const std::shared_ptr<DataFrame::Column::ConcreteWrapper<Categorical>>& new_wrapper,
+            DType old_wrapper_type)
+    {
+        std::size_t sz = wrapper_->Size();
+        switch (old_wrapper_type) {
+            case DType::String: {
+                auto ptr = util::reinterpret_pointer_cast<ConcreteWrapper<std::string>>(wrapper_);
+                const auto& data = ptr->data_;
+                new_wrapper->data_.Reserve(sz);
+                for (std::size_t i = 0; i < sz; ++i) {
+                    new_wrapper->data_.push_back(data[i]);
+                }
+                return true;
+            }
+            case DType::None:
+            case DType::Categorical:
+                return true;
+            default:
+                return false;
+        }
+    }
+
     bool ConvertDType(const DType dtype) {
         auto wrapper_type = wrapper_->GetDType();
         if (wrapper_type == dtype) {
@@ -172,27 +377,21 @@ struct DataFrame::Column::Box {
         else if (wrapper_type == DType::Other) {
             return false; // Don't know the DType, so can't convert.
         }
+        // A column with no values yet becomes a column of nulls of the new type.
+        if (wrapper_type == DType::None || wrapper_type == DType::Empty) {
+            auto new_wrapper_ = MakeNullWrapper(dtype, wrapper_->Size());
+            if (!new_wrapper_) {
+                return false;
+            }
+            SetWrapper(std::move(new_wrapper_));
+            return true;
+        }
+        // The conversions read the wrapper's data directly.
+        Compact();
         // Create a new wrapper.
         bool status = false;
         std::shared_ptr<Wrapper> new_wrapper_;
         switch (dtype) {
-            case DType::None:
-                new_wrapper_ = std::make_shared<ConcreteWrapper<NoneDType>>();
-                status = true;
-                break;
-            case DType::Empty:
-                new_wrapper_ = std::make_shared<ConcreteWrapper<EmptyDType>>();
-                status = true;
-                break;
-            case DType::Integer: {
-                if (wrapper_type == DType::None) {
-                    status = true;
-                    new_wrapper_ = std::make_shared<ConcreteWrapper<int>>();
-                } else {
-                    return false; // If we are here, wrapper_type != DType::Integer
-                }
-                break;
-            }
             case DType::Float: {
                 auto wrapper = std::make_shared<ConcreteWrapper<float>>();
                 status = TryConvert(wrapper, wrapper_type);
@@ -205,26 +404,73 @@ struct DataFrame::Column::Box {
                 new_wrapper_ = wrapper;
                 break;
             }
-            case DType::Bool:
-                status = true;
-                if (wrapper_type == DType::None) {
-                    new_wrapper_ = std::make_shared<ConcreteWrapper<bool>>();
-                } else if (wrapper_type == DType::Empty) {
-                    new_wrapper_ = std::make_shared<ConcreteWrapper<bool>>(wrapper_->Size(), -1);
-                } else {
-                    return false; // If we are here, wrapper_type != DType::Bool
-                }
-                break;
             case DType::String: {
                 auto wrapper = std::make_shared<ConcreteWrapper<std::string>>();
                 status = TryConvert(wrapper, wrapper_type);
                 new_wrapper_ = wrapper;
                 break;
             }
+            case DType::Categorical: {
+                auto wrapper = std::make_shared<ConcreteWrapper<Categorical>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::Integer: {
+                auto wrapper = std::make_shared<ConcreteWrapper<int>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::Int8: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::int8_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::Int16: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::int16_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::Int64: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::int64_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::UInt8: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::uint8_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::UInt16: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::uint16_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::UInt32: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::uint32_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
+            case DType::UInt64: {
+                auto wrapper = std::make_shared<ConcreteWrapper<std::uint64_t>>();
+                status = TryConvert(wrapper, wrapper_type);
+                new_wrapper_ = wrapper;
+                break;
+            }
             default:
-                return false; // We should never get here.
+                // Values cannot be converted to None, Empty, or Bool.
+                return false;
         }
         if (status) {
+            // Nulls stay null.
+            new_wrapper_->validity = wrapper_->validity;
             SetWrapper(std::move(new_wrapper_));
         }
         return status;
@@ -232,6 +478,9 @@ struct DataFrame::Column::Box {
 
     //! \brief The wrapper the box contains. This wraps the actual data.
     std::shared_ptr<Wrapper> wrapper_;
+
+    //! \brief Held by every box that shares the same wrapper, so its use count is the number of boxes sharing it.
+    std::shared_ptr<char> owners_ = std::make_shared<char>();
 };
 
 #endif // __BOX_TEMPLATES_H__
@@ -11,19 +11,27 @@ template<typename T>
 struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
     using value_type = util::remove_cvref_t<T>;
 
+    //! \brief Whether the wrapper only holds placeholders (None or Empty), whose entries are always null.
+    static constexpr bool kPlaceholder =
+            std::is_same<value_type, NoneDType>::value || std::is_same<value_type, EmptyDType>::value;
+
     ConcreteWrapper() = default;
 
-    explicit ConcreteWrapper(std::size_t size) : data_(size) {}
+    explicit ConcreteWrapper(std::size_t size) : data_(size) {
+        validity.Reset(size, !kPlaceholder);
+    }
 
     ConcreteWrapper(std::size_t size, const T& value)
-            : data_(size, static_cast<value_type>(value)) {}
+            : data_(size, static_cast<value_type>(value)) {
+        validity.Reset(size, !kPlaceholder);
+    }
 
     std::size_t Size() const override {
-        return data_.size();
+        return chunks_.empty() ? data_.size() : chunk_ends_.back();
     }
 
     bool Empty() const override {
-        return data_.empty();
+        return Size() == 0;
     }
 
     DType GetDType() const override {
@@ -33,10 +41,10 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
     bool Copy(const std::shared_ptr<Wrapper>& ptr) override {
         auto c_ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(ptr);
         if (c_ptr) { // Successful cast.
-            data_.resize(c_ptr->data_.size());
-            for (std::size_t i = 0; i < data_.size(); ++i) {
-                data_[i] = c_ptr->data_[i];
-            }
+            data_ = c_ptr->data_;
+            chunks_ = c_ptr->chunks_;
+            chunk_ends_ = c_ptr->chunk_ends_;
+            validity = c_ptr->validity;
             return true;
         }
         return false; // Different types.
@@ -45,26 +53,69 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
     std::shared_ptr<Wrapper> Clone() const override {
         auto ptr = std::make_shared<ConcreteWrapper<T>>();
         ptr->data_ = data_;
+        if (!chunks_.empty()) {
+            ptr->data_.Reserve(Size());
+            for (const auto& chunk : chunks_) {
+                ptr->data_.append(chunk);
+            }
+        }
+        ptr->validity = validity;
         return ptr;
     }
 
-    std::shared_ptr<Wrapper> Clone(const IMapType& index_map) const override {
+    std::shared_ptr<Wrapper> Clone(const IndexMap& index_map) const override {
         auto ptr = std::make_shared<ConcreteWrapper<T>>();
-        ptr->data_.Reserve(index_map->size());
-        for (std::size_t i = 0; i < index_map->size(); ++i) {
-            ptr->data_.push_back(data_[(*index_map)[i]]);
-        }
-        ptr->data_ = data_;
+        ptr->data_.Reserve(index_map.Size());
+        EntryReader entry(*this);
+        index_map.ForEach(index_map.Size(), [&](std::size_t index) {
+            ptr->data_.push_back(entry(index));
+        });
+        ptr->validity = validity.Gather(index_map);
         return ptr;
     }
 
     void ToStream(std::size_t index, std::ostream& out) const override {
-        if (IsNaN<value_type>::check(data_[index])) {
+        if (!validity.IsValid(index) || IsNaN<value_type>::check(Entry(index))) {
             out << "";
         }
         else {
-            Format<value_type>::ToStream(data_[index], out);
+            Format<value_type>::ToStream(Entry(index), out);
+        }
+    }
+
+    void FormatRange(std::size_t first, std::size_t last, const IndexMap& index_map, char delimiter,
+                     char quote, std::string& text, std::vector<std::size_t>& ends) const override {
+        text.clear();
+        ends.clear();
+        ends.reserve(last - first);
+        EntryReader entry(*this);
+        index_map.ForEach(first, last, [&](std::size_t index) {
+            const auto& value = entry(index);
+            if (validity.IsValid(index) && !IsNaN<value_type>::check(value)) {
+                TextFormat<value_type>::Append(value, text, delimiter, quote);
+            }
+            ends.push_back(text.size());
+        });
+    }
+
+    bool WriteBinary(std::ostream& out, const IndexMap& index_map, std::size_t num_rows) const override {
+        if (!chunks_.empty()) {
+            // The binary formats write contiguous data.
+            DFVector<value_type> data(data_);
+            for (const auto& chunk : chunks_) {
+                data.append(chunk);
+            }
+            return BinaryFormat<value_type>::Write(data, index_map, num_rows, out);
         }
+        return BinaryFormat<value_type>::Write(data_, index_map, num_rows, out);
+    }
+
+    bool ReadBinary(const char* begin, std::size_t size, std::size_t num_rows,
+                    const std::shared_ptr<const void>& owner) override {
+        chunks_.clear();
+        chunk_ends_.clear();
+        validity.Reset(num_rows, !kPlaceholder);
+        return BinaryFormat<value_type>::Read(begin, size, num_rows, data_, owner);
     }
 
     bool IsSameType(const std::shared_ptr<Wrapper>& wrapper) const override {
@@ -74,96 +125,436 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
     bool CheckEquals(const std::shared_ptr<Wrapper>& wrapper) const override {
         auto c_ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(wrapper);
         if (c_ptr) {
-            return data_ == c_ptr->data_;
+            if (chunks_.empty() && c_ptr->chunks_.empty()) {
+                return data_ == c_ptr->data_ && validity.Words() == c_ptr->validity.Words();
+            }
+            if (Size() != c_ptr->Size() || validity.Words() != c_ptr->validity.Words()) {
+                return false;
+            }
+            EntryReader lhs(*this), rhs(*c_ptr);
+            for (std::size_t i = 0; i < Size(); ++i) {
+                if (!(lhs(i) == rhs(i))) {
+                    return false;
+                }
+            }
+            return true;
         }
         return false;
     }
 
-    void AddByString(const std::string& value) override {
-        data_.push_back(ToType<value_type>(value));
+    void AddByString(std::string_view value) override {
+        Compact();
+        if constexpr (std::is_same<value_type, std::string>::value) {
+            // The bytes are copied straight into the column's buffer.
+            data_.push_back(value);
+        }
+        else {
+            data_.push_back(ToType<value_type>(value));
+        }
+        validity.PushBack(!kPlaceholder && !value.empty());
+    }
+
+    void AddParsed(const ParsedField& field, std::string_view value) override {
+        Compact();
+        // Fields that do not hold a value of the wrapper's type are stored as nulls.
+        bool valid = IsValidParsed<value_type>(field);
+        if constexpr (std::is_same<value_type, std::string>::value) {
+            data_.push_back(valid ? value : std::string_view());
+        }
+        else {
+            data_.push_back(valid ? FromParsed<value_type>(field, value) : NullValue<value_type>::value());
+        }
+        validity.PushBack(valid);
+    }
+
+    void AddConverted(std::string_view value) override {
+        if constexpr (std::is_same<value_type, std::string>::value || std::is_same<value_type, Categorical>::value) {
+            // Strings do not need to be parsed.
+            Compact();
+            data_.push_back(value);
+            validity.PushBack(!value.empty());
+        }
+        else {
+            AddParsed(ParseField(value), value);
+        }
+    }
+
+    void AddInferred(const ParsedField& field, std::string_view value) override {
+        if constexpr (std::is_same<value_type, Timestamp>::value) {
+            // Entries from before the column held timestamps are nulls, which have no text.
+            source_text_.resize(Size());
+            source_text_.push_back(value);
+        }
+        AddParsed(field, value);
+    }
+
+    void ReleaseSourceText() override {
+        source_text_ = DFVector<std::string>();
+    }
+
+    void Reserve(std::size_t size) override {
+        Compact();
+        data_.Reserve(size);
+        validity.Reserve(size);
+    }
+
+    void Clear() override {
+        data_.resize(0);
+        chunks_.clear();
+        chunk_ends_.clear();
+        validity.Reset();
+        source_text_.resize(0);
     }
 
     bool Append(const std::shared_ptr<Wrapper>& wrapper) override {
         auto c_ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(wrapper);
         if (c_ptr) {
-            data_.append(c_ptr->data_);
+            if (c_ptr.get() == this) {
+                c_ptr = util::reinterpret_pointer_cast<ConcreteWrapper<T>>(Clone());
+            }
+            if (!source_text_.empty() || !c_ptr->source_text_.empty()) {
+                source_text_.resize(Size());
+                source_text_.append(c_ptr->source_text_);
+                source_text_.resize(Size() + c_ptr->Size());
+            }
+            // The appended data is linked on as new chunks, so the entries already in the column stay where they are.
+            LinkChunk(c_ptr->data_);
+            for (const auto& chunk : c_ptr->chunks_) {
+                LinkChunk(chunk);
+            }
+            validity.Append(c_ptr->validity);
             return true;
         }
         return false;
     }
 
+    void Compact() override {
+        if (chunks_.empty()) {
+            return;
+        }
+        data_.Reserve(Size());
+        for (const auto& chunk : chunks_) {
+            data_.append(chunk);
+        }
+        chunks_.clear();
+        chunk_ends_.clear();
+    }
+
+    std::size_t NumChunks() const override {
+        return 1 + chunks_.size();
+    }
+
+    //! \brief The index-th entry of the column, which may be in data_ or in one of the chunks.
+    typename DFVector<value_type>::const_reference Entry(std::size_t index) const {
+        if (chunks_.empty() || index < data_.size()) {
+            return data_[index];
+        }
+        auto chunk = std::upper_bound(chunk_ends_.begin(), chunk_ends_.end(), index) - chunk_ends_.begin();
+        return chunks_[chunk][index - (chunk == 0 ? data_.size() : chunk_ends_[chunk - 1])];
+    }
+
+    //! \brief Reads entries of a column by index, remembering which chunk (or data_) the last entry was in. Entries
+    //! read in increasing order, as they are through an index map, only look for a chunk when they pass the end of the
+    //! last one.
+    class EntryReader {
+    public:
+        explicit EntryReader(const ConcreteWrapper& wrapper)
+                : wrapper_(wrapper), data_(&wrapper.data_), end_(wrapper.data_.size()) {}
+
+        typename DFVector<value_type>::const_reference operator()(std::size_t index) {
+            if (index < begin_ || end_ <= index) {
+                Seek(index);
+            }
+            return (*data_)[index - begin_];
+        }
+
+    private:
+        void Seek(std::size_t index) {
+            const auto& ends = wrapper_.chunk_ends_;
+            if (index < wrapper_.data_.size()) {
+                data_ = &wrapper_.data_;
+                begin_ = 0;
+                end_ = wrapper_.data_.size();
+                return;
+            }
+            auto chunk = static_cast<std::size_t>(std::upper_bound(ends.begin(), ends.end(), index) - ends.begin());
+            data_ = &wrapper_.chunks_[chunk];
+            begin_ = chunk == 0 ? wrapper_.data_.size() : ends[chunk - 1];
+            end_ = ends[chunk];
+        }
+
+        const ConcreteWrapper& wrapper_;
+        const DFVector<value_type>* data_;
+        std::size_t begin_ = 0, end_;
+    };
+
     // ========================================
     //  Comparisons.
     // ========================================
 
-    Indicator cmp_less(const std::shared_ptr<Wrapper>& wrapper) const override {
-        if (data_.size() != wrapper->Size()) {
+    Indicator CompareColumn(CompareOp op, const IndexMap& index_map, const Wrapper& other,
+                            const IndexMap& other_map) const override {
+        if constexpr (std::is_arithmetic<value_type>::value && !std::is_same<value_type, bool>::value) {
+            // Numbers can be compared with numbers of any type.
+            Indicator output;
+            VisitNumbers(other, [&] (const auto& rhs) { output = CompareWith(op, index_map, rhs, other_map); });
+            return output;
+        }
+        else if (auto ptr = dynamic_cast<const ConcreteWrapper<T>*>(&other)) {
+            return CompareWith(op, index_map, *ptr, other_map);
+        }
+        return {};
+    }
+
+    //! \brief Compare the entries of this wrapper (through index_map) with the entries of another wrapper (through
+    //! other_map), entry by entry. If neither wrapper has chunks and both hold int, float, or double entries, the
+    //! vectorized kernels are used. Otherwise, the entries are compared one at a time, a batch of indices at a time.
+    template<typename U>
+    Indicator CompareWith(CompareOp op, const IndexMap& index_map, const ConcreteWrapper<U>& other,
+                          const IndexMap& other_map) const {
+        using other_type = typename ConcreteWrapper<U>::value_type;
+        using comparison_type = typename detail::ColumnComparisonType<value_type, other_type>::type;
+        const auto size = index_map.Size(Size());
+        if (other_map.Size(other.Size()) != size) {
             return {};
         }
-        auto ptr = std::dynamic_pointer_cast<ConcreteWrapper<T>>(wrapper);
-        if (ptr) {
-            Indicator output(data_.size());
-            for (std::size_t i = 0; i < data_.size(); ++i) {
-                output[i] = data_[i] < ptr->data_[i];
+        Indicator output(size);
+        auto* out = output.Words().data();
+        if constexpr (detail::kHasCompareKernel<value_type> && detail::kHasCompareKernel<other_type>) {
+            if (chunks_.empty() && other.chunks_.empty()) {
+                CompareSelections(op, data_.data(), index_map, other.data_.data(), other_map, size, out);
+                return other.MaskNulls(MaskNulls(std::move(output), index_map), other_map);
             }
-            return output;
         }
-        return {};
+        EntryReader lhs_entry(*this);
+        typename ConcreteWrapper<U>::EntryReader rhs_entry(other);
+        auto lhs = [&] (std::size_t index) -> decltype(auto) {
+            if constexpr (std::is_void<comparison_type>::value) {
+                return lhs_entry(index);
+            }
+            else {
+                return static_cast<comparison_type>(lhs_entry(index));
+            }
+        };
+        auto rhs = [&] (std::size_t index) -> decltype(auto) {
+            if constexpr (std::is_void<comparison_type>::value) {
+                return rhs_entry(index);
+            }
+            else {
+                return static_cast<comparison_type>(rhs_entry(index));
+            }
+        };
+        const bool comparable = detail::WithComparison(op, [&] (auto compare) {
+            if constexpr (std::is_invocable_r<bool, decltype(compare), decltype(lhs(0)), decltype(rhs(0))>::value) {
+                std::size_t lhs_batch[detail::kGatherBatch], rhs_batch[detail::kGatherBatch];
+                for (std::size_t first = 0; first < size; first += detail::kGatherBatch) {
+                    const auto count = std::min(detail::kGatherBatch, size - first);
+                    const auto* lhs_indices = index_map.GetIndices(first, count, lhs_batch);
+                    const auto* rhs_indices = other_map.GetIndices(first, count, rhs_batch);
+                    for (std::size_t j = 0; j < count; ++j) {
+                        const auto i = first + j;
+                        out[i >> 6] |= static_cast<std::uint64_t>(
+                                static_cast<bool>(compare(lhs(lhs_indices[j]), rhs(rhs_indices[j])))) << (i & 63);
+                    }
+                }
+                return true;
+            }
+            else {
+                return false;
+            }
+        });
+        if (!comparable) {
+            return {};
+        }
+        return other.MaskNulls(MaskNulls(std::move(output), index_map), other_map);
+    }
+
+    //! \brief If a wrapper holds numbers (not bools), call the function with the wrapper, cast to its concrete type.
+    //! Returns false if the wrapper does not hold numbers.
+    template<typename Function>
+    static bool VisitNumbers(const Wrapper& wrapper, Function&& function) {
+        switch (wrapper.GetDType()) {
+            case DType::Integer:
+                function(static_cast<const ConcreteWrapper<int>&>(wrapper));
+                return true;
+            case DType::Float:
+                function(static_cast<const ConcreteWrapper<float>&>(wrapper));
+                return true;
+            case DType::Double:
+                function(static_cast<const ConcreteWrapper<double>&>(wrapper));
+                return true;
+            case DType::Int8:
+                function(static_cast<const ConcreteWrapper<std::int8_t>&>(wrapper));
+                return true;
+            case DType::Int16:
+                function(static_cast<const ConcreteWrapper<std::int16_t>&>(wrapper));
+                return true;
+            case DType::Int64:
+                function(static_cast<const ConcreteWrapper<std::int64_t>&>(wrapper));
+                return true;
+            case DType::UInt8:
+                function(static_cast<const ConcreteWrapper<std::uint8_t>&>(wrapper));
+                return true;
+            case DType::UInt16:
+                function(static_cast<const ConcreteWrapper<std::uint16_t>&>(wrapper));
+                return true;
+            case DType::UInt32:
+                function(static_cast<const ConcreteWrapper<std::uint32_t>&>(wrapper));
+                return true;
+            case DType::UInt64:
+                function(static_cast<const ConcreteWrapper<std::uint64_t>&>(wrapper));
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    Indicator lt(double value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Lt, value, index_map);
+    }
+
+    Indicator gt(double value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Gt, value, index_map);
+    }
+
+    Indicator le(double value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Le, value, index_map);
+    }
+
+    Indicator ge(double value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ge, value, index_map);
+    }
+
+    Indicator eq(double value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Eq, value, index_map);
+    }
+
+    Indicator ne(double value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ne, value, index_map);
+    }
+
+    Indicator lt(int value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Lt, value, index_map);
+    }
+
+    Indicator gt(int value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Gt, value, index_map);
+    }
+
+    Indicator le(int value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Le, value, index_map);
     }
 
-    Indicator lt(double value, const IMapType& index_map) const override {
-        return DoComparison<double, T>::compare(
-                [] (auto d, auto v) { return d < v; }, data_, index_map, value);
+    Indicator ge(int value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ge, value, index_map);
     }
 
-    Indicator gt(double value, const IMapType& index_map) const override {
-        return DoComparison<double, T>::compare(
-                [] (auto d, auto v) { return d > v; }, data_, index_map, value);
+    Indicator eq(int value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Eq, value, index_map);
     }
 
-    Indicator le(double value, const IMapType& index_map) const override {
-        return DoComparison<double, T>::compare(
-                [] (auto d, auto v) { return d <= v; }, data_, index_map, value);
+    Indicator ne(int value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ne, value, index_map);
     }
 
-    Indicator ge(double value, const IMapType& index_map) const override {
-        return DoComparison<double, T>::compare(
-                [] (auto d, auto v) { return d >= v; }, data_, index_map, value);
+    Indicator eq(std::string value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Eq, value, index_map);
     }
 
-    Indicator eq(double value, const IMapType& index_map) const override {
-        return DoComparison<double, T>::compare(
-                [] (auto d, auto v) { return d == v; }, data_, index_map, value);
+    Indicator ne(std::string value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ne, value, index_map);
     }
 
-    Indicator lt(int value, const IMapType& index_map) const override {
-        return DoComparison<int, T>::compare(
-                [] (auto d, auto v) { return d < v; }, data_, index_map, value);
+    //! \brief Compare the entries of the column (through the index map, if there is one) with a value.
+    template<typename Value>
+    Indicator Compare(CompareOp op, const Value& value, const IndexMap& index_map) const {
+        if constexpr (std::is_same<value_type, Categorical>::value && std::is_same<Value, std::string>::value) {
+            if (op == CompareOp::Eq || op == CompareOp::Ne) {
+                // Look the string up in the dictionary (of each chunk) once, then compare codes.
+                return ByChunk([&] (const DFVector<value_type>& data, const IndexMap& map) {
+                    std::uint32_t code;
+                    if (!data.Dictionary().Find(value, code)) {
+                        return Indicator(map.Size(data.size()), op == CompareOp::Ne);
+                    }
+                    return DoComparison<std::uint32_t, std::uint32_t>::compare(op, data.Codes(), map, code);
+                }, index_map);
+            }
+        }
+        return ByChunk([&] (const DFVector<value_type>& data, const IndexMap& map) {
+            return DoComparison<Value, T>::compare(op, data, map, value);
+        }, index_map);
+    }
+
+    //! \brief Run a kernel, which makes an indicator from a dfvector and an index map, over the column chunk by chunk.
+    //! Each chunk's kernel only sees the entries of the index map that fall in that chunk. Nulls are masked. Returns an
+    //! empty indicator if the kernel does not apply to the column's type.
+    template<typename Kernel>
+    Indicator ByChunk(Kernel&& kernel, const IndexMap& index_map) const {
+        if (chunks_.empty()) {
+            return MaskNulls(kernel(data_, index_map), index_map);
+        }
+        Indicator output;
+        output.reserve(index_map.Size(Size()));
+        bool applies = true;
+        ForEachChunk(index_map, [&](const DFVector<value_type>& data, const IndexMap& map, std::size_t count) {
+            if (applies) {
+                auto part = kernel(data, map);
+                applies = part.size() == count;
+                output.Append(part);
+            }
+        });
+        if (!applies) {
+            return {};
+        }
+        return MaskNulls(std::move(output), index_map);
+    }
+
+    //! \brief Call function(data, map, count) with data_ and then each chunk, where map selects the count entries of
+    //! the chunk that the index map selects, indexed from the start of the chunk. The index map and the chunk
+    //! boundaries are walked together, so chunks with no selected entries are skipped, and a chunk whose entries are
+    //! all selected gets a full index map.
+    template<typename Function>
+    void ForEachChunk(const IndexMap& index_map, Function&& function) const {
+        const auto size = index_map.Size(Size());
+        std::size_t begin = 0, position = 0;
+        auto visit = [&](const DFVector<value_type>& data) {
+            const auto end = begin + data.size();
+            const auto next = std::min(size, index_map.Rank(end));
+            if (position < next) {
+                function(data, next - position == data.size() ? IndexMap() : index_map.Slice(position, next, begin),
+                         next - position);
+            }
+            begin = end;
+            position = next;
+        };
+        visit(data_);
+        for (const auto& chunk : chunks_) {
+            visit(chunk);
+        }
     }
 
-    Indicator gt(int value, const IMapType& index_map) const override {
-        return DoComparison<int, T>::compare(
-                [] (auto d, auto v) { return d > v; }, data_, index_map, value);
+    Indicator lt(const Timestamp& value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Lt, value, index_map);
     }
 
-    Indicator le(int value, const IMapType& index_map) const override {
-        return DoComparison<int, T>::compare(
-                [] (auto d, auto v) { return d <= v; }, data_, index_map, value);
+    Indicator gt(const Timestamp& value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Gt, value, index_map);
     }
 
-    Indicator ge(int value, const IMapType& index_map) const override {
-        return DoComparison<int, T>::compare(
-                [] (auto d, auto v) { return d >= v; }, data_, index_map, value);
+    Indicator le(const Timestamp& value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Le, value, index_map);
     }
 
-    Indicator eq(int value, const IMapType& index_map) const override {
-        return DoComparison<int, T>::compare(
-                [] (auto d, auto v) { return d == v; }, data_, index_map, value);
+    Indicator ge(const Timestamp& value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ge, value, index_map);
     }
 
-    Indicator eq(std::string value, const IMapType& index_map) const override {
-        return DoComparison<std::string, T>::compare(
-                [] (auto d, auto v) { return d == v; }, data_, index_map, value);
+    Indicator eq(const Timestamp& value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Eq, value, index_map);
+    }
+
+    Indicator ne(const Timestamp& value, const IndexMap& index_map) const override {
+        return Compare(CompareOp::Ne, value, index_map);
     }
 
     // ========================================
@@ -198,6 +589,117 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
         return castVector<double>();
     }
 
+    void ReadDoubles(const IndexMap& index_map, std::size_t first, std::size_t count, double* out) const override {
+        if constexpr (std::is_arithmetic<value_type>::value) {
+            if (chunks_.empty() && index_map.IsContiguous()) {
+                const auto offset = index_map.First() + first;
+                const auto* entries = data_.data() + offset;
+                for (std::size_t i = 0; i < count; ++i) {
+                    out[i] = static_cast<double>(entries[i]);
+                }
+                if (!validity.AllValid()) {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        if (!validity.IsValid(offset + i)) {
+                            out[i] = std::numeric_limits<double>::quiet_NaN();
+                        }
+                    }
+                }
+                return;
+            }
+            EntryReader entry(*this);
+            std::size_t batch[detail::kGatherBatch];
+            for (std::size_t done = 0; done < count; done += detail::kGatherBatch) {
+                const auto size = std::min(detail::kGatherBatch, count - done);
+                const auto* indices = index_map.GetIndices(first + done, size, batch);
+                for (std::size_t i = 0; i < size; ++i) {
+                    out[done + i] = validity.IsValid(indices[i]) ? static_cast<double>(entry(indices[i]))
+                                                                 : std::numeric_limits<double>::quiet_NaN();
+                }
+            }
+        }
+        else {
+            std::fill(out, out + count, std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+
+    Statistics Describe(const IndexMap& index_map, bool with_variance) const override {
+        StatisticsAccumulator accumulator(with_variance);
+        if constexpr (std::is_arithmetic<value_type>::value) {
+            // Large views are split into ranges of whole blocks, which are reduced on their own threads. The results
+            // are merged in order, so they do not depend on how the threads were scheduled.
+            const auto size = index_map.Size(Size());
+            const auto num_threads = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                           size / StatisticsAccumulator::kMinThreadSize);
+            if (num_threads <= 1) {
+                return DescribeRange(index_map, 0, size, with_variance).Result();
+            }
+            constexpr auto block = StatisticsAccumulator::kBlockSize;
+            const auto range_size = (size / num_threads + block - 1) / block * block;
+            std::vector<std::future<StatisticsAccumulator>> workers;
+            for (std::size_t first = 0; first < size; first += range_size) {
+                workers.push_back(std::async(std::launch::async, [&, first] {
+                    return DescribeRange(index_map, first, std::min(size, first + range_size), with_variance);
+                }));
+            }
+            for (auto& worker : workers) {
+                worker.wait();
+            }
+            for (auto& worker : workers) {
+                accumulator.Merge(worker.get());
+            }
+        }
+        return accumulator.Result();
+    }
+
+    //! \brief Accumulate the statistics of entries [first, last) of the view given by the index map, a block at a time.
+    //! A contiguous view of doubles without nulls is reduced in place. Otherwise, each block is read into a buffer.
+    StatisticsAccumulator DescribeRange(const IndexMap& index_map, std::size_t first, std::size_t last,
+                                        bool with_variance) const {
+        StatisticsAccumulator accumulator(with_variance);
+        constexpr auto block = StatisticsAccumulator::kBlockSize;
+        if constexpr (std::is_same<value_type, double>::value) {
+            if (chunks_.empty() && index_map.IsContiguous() && validity.AllValid()) {
+                const auto* entries = data_.data() + index_map.First();
+                for (auto i = first; i < last; i += block) {
+                    accumulator.Add(entries + i, std::min(block, last - i));
+                }
+                return accumulator;
+            }
+        }
+        double buffer[block];
+        for (auto i = first; i < last; i += block) {
+            const auto count = std::min(block, last - i);
+            ReadDoubles(index_map, i, count, buffer);
+            accumulator.Add(buffer, count);
+            if constexpr (std::is_integral<value_type>::value && !std::is_same<value_type, bool>::value) {
+                // Large 64 bit integers are not exact as doubles, so integers are also summed exactly, while the
+                // block is in cache.
+                accumulator.AddIntegerSum(SumIntegers(index_map, i, i + count));
+            }
+        }
+        return accumulator;
+    }
+
+    //! \brief The exact sum of the valid entries [first, last) of the view given by the index map, for columns of
+    //! integers.
+    IntegerSum SumIntegers(const IndexMap& index_map, std::size_t first, std::size_t last) const {
+        IntegerSum sum = 0;
+        if (chunks_.empty() && index_map.IsContiguous() && validity.AllValid()) {
+            const auto* entries = data_.data() + index_map.First();
+            for (auto i = first; i < last; ++i) {
+                sum += entries[i];
+            }
+            return sum;
+        }
+        EntryReader entry(*this);
+        index_map.ForEach(first, last, [&](std::size_t index) {
+            if (validity.IsValid(index)) {
+                sum += entry(index);
+            }
+        });
+        return sum;
+    }
+
     std::vector<std::string> castToString() override {
         return castVector<std::string>();
     }
@@ -205,10 +707,10 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
     template<typename Type, typename Target, bool can_cast>
     struct Caster {
         static std::vector<Target> castVector(const DFVector<Type>& data) {
-            std::vector<Target> output;
-            output.reserve(data.size());
-            for (const auto& holder : data.data_) {
-                output.push_back(static_cast<Target>(holder.value_));
+            std::vector<Target> output(data.size());
+            const auto& source = Entries(data);
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                output[i] = static_cast<Target>(source[i]);
             }
             return output;
         }
@@ -223,27 +725,48 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
 
     template<typename Target>
     std::vector<Target> castVector() {
-        if (data_.empty()) {
-            return {};
-        } else {
-            return Caster<value_type, Target, is_castable<value_type, Target>::value>::castVector(data_);
+        using CasterType = Caster<value_type, Target, is_castable<value_type, Target>::value>;
+        // Cast chunk by chunk, so the column is only read.
+        auto output = CasterType::castVector(data_);
+        for (const auto& chunk : chunks_) {
+            auto part = CasterType::castVector(chunk);
+            output.insert(output.end(), part.begin(), part.end());
         }
+        return output;
     }
 
     // ========================================
     //  Other functions.
     // ========================================
 
-    void SetAll(const T& value, const IMapType& index_map) {
-        if (index_map) {
-            for (std::size_t index : *index_map) {
-                data_[index] = value;
+    void SetAll(const T& value, const IndexMap& index_map) {
+        Compact();
+        if constexpr (std::is_same<value_type, std::string>::value) {
+            if (!index_map.IsFull()) {
+                // Setting strings one at a time would move the bytes after each one, so the data is rebuilt instead.
+                std::vector<bool> selected(data_.size());
+                index_map.ForEach(index_map.Size(), [&](std::size_t index) {
+                    selected[index] = true;
+                    validity.Set(index, true);
+                });
+                DFVector<value_type> data;
+                data.Reserve(data_.size());
+                for (std::size_t i = 0; i < data_.size(); ++i) {
+                    data.push_back(selected[i] ? std::string_view(value) : std::as_const(data_)[i]);
+                }
+                data_ = std::move(data);
+                return;
             }
         }
+        if (!index_map.IsFull()) {
+            index_map.ForEach(index_map.Size(), [&](std::size_t index) {
+                data_[index] = value;
+                validity.Set(index, !kPlaceholder);
+            });
+        }
         else {
-            for (auto& entry : data_.data_) {
-                entry.value_ = value;
-            }
+            data_ = DFVector<value_type>(data_.size(), value);
+            validity.Reset(data_.size(), !kPlaceholder);
         }
     }
 
@@ -251,7 +774,29 @@ struct DataFrame::Column::ConcreteWrapper : public DataFrame::Column::Wrapper {
     //  Data
     // ========================================
 
+    //! \brief The entries of the column, followed by the entries of the chunks.
     DFVector<value_type> data_;
+
+    //! \brief Data appended onto the column, in order. Appending links on a new chunk instead of growing data_, so the
+    //! entries already in the column are never reallocated or copied. Compact coalesces the chunks into data_, which
+    //! is done before anything that needs all the entries to be contiguous.
+    std::vector<DFVector<value_type>> chunks_;
+
+    //! \brief The index one past the last entry of each chunk.
+    std::vector<std::size_t> chunk_ends_;
+
+    //! \brief For timestamp columns whose dtype is being inferred, the text that each entry was read from, so the
+    //! column can be widened to strings without losing it. Entries past the end, or with empty text, have none.
+    DFVector<std::string> source_text_;
+
+private:
+    void LinkChunk(const DFVector<value_type>& data) {
+        if (!data.empty()) {
+            auto end = Size() + data.size();
+            chunks_.push_back(data);
+            chunk_ends_.push_back(end);
+        }
+    }
 };
 
 #endif // __CONCRETE_WRAPPER_TEMPLATES_H__
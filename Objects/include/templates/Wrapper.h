@@ -22,15 +22,31 @@ struct DataFrame::Column::Wrapper {
     //! other wrapper was of a different type.
     virtual bool Copy(const std::shared_ptr<Wrapper>& ptr) = 0;
 
-    //! \brief Return a copy of the wrapper.
+    //! \brief Return a copy of the wrapper. The copy is stored contiguously, even if the wrapper has chunks.
     virtual std::shared_ptr<Wrapper> Clone() const = 0;
 
     //! \brief Return a copy of the wrapper, only keeping the data indicated by the index_map.
-    virtual std::shared_ptr<Wrapper> Clone(const IMapType& index_map) const = 0;
+    virtual std::shared_ptr<Wrapper> Clone(const IndexMap& index_map) const = 0;
 
     //! \brief Write the index-th element of the wrapper to an ostream.
     virtual void ToStream(std::size_t index, std::ostream& out) const = 0;
 
+    //! \brief Format the elements [first, last) of the wrapper (or the elements that the index map gives for those
+    //! positions, if there is an index map) as csv fields. The text replaces the contents of text, and the end of each
+    //! element's text is recorded in ends.
+    virtual void FormatRange(std::size_t first, std::size_t last, const IndexMap& index_map, char delimiter,
+                             char quote, std::string& text, std::vector<std::size_t>& ends) const = 0;
+
+    //! \brief Write the elements [0, num_rows) of the wrapper (or the elements that the index map gives for those
+    //! positions) to a stream in the binary column format. Returns false if the type has no binary format.
+    virtual bool WriteBinary(std::ostream& out, const IndexMap& index_map, std::size_t num_rows) const = 0;
+
+    //! \brief Replace the contents of the wrapper with num_rows elements stored in the binary column format in
+    //! [begin, begin + size). If owner is not null, it keeps that memory alive, and fixed width elements are used in
+    //! place instead of being copied. Returns false if the data is not valid.
+    virtual bool ReadBinary(const char* begin, std::size_t size, std::size_t num_rows,
+                            const std::shared_ptr<const void>& owner) = 0;
+
     //! \brief Check if another wrapper has the same underlying type as this wrapper.
     virtual bool IsSameType(const std::shared_ptr<Wrapper>& wrapper) const = 0;
 
@@ -38,30 +54,96 @@ struct DataFrame::Column::Wrapper {
     virtual bool CheckEquals(const std::shared_ptr<Wrapper>& wrapper) const = 0;
 
     //! \brief Add data to the wrapper via its string representation.
-    virtual void AddByString(const std::string& value) = 0;
+    virtual void AddByString(std::string_view value) = 0;
+
+    //! \brief Add data to the wrapper from a field that has already been classified and converted by ParseField.
+    virtual void AddParsed(const ParsedField& field, std::string_view value) = 0;
+
+    //! \brief Add data to the wrapper via its string representation, converting it directly to the wrapper's type.
+    //! Unlike AddByString, the value is parsed in the same single pass that AddParsed values are.
+    virtual void AddConverted(std::string_view value) = 0;
+
+    //! \brief Add a field to a column whose dtype is being inferred, as AddParsed does. Timestamp columns also keep
+    //! the text of the field, so if a later field widens the column to strings, its entries keep their original text.
+    virtual void AddInferred(const ParsedField& field, std::string_view value) = 0;
+
+    //! \brief Release the text kept by AddInferred. This is done once the dtype of the column is final.
+    virtual void ReleaseSourceText() = 0;
+
+    //! \brief Reserve space for a number of entries.
+    virtual void Reserve(std::size_t size) = 0;
+
+    //! \brief Remove all the entries, keeping the memory that was allocated for them.
+    virtual void Clear() = 0;
 
     //! \brief Append the contents of another
     virtual bool Append(const std::shared_ptr<Wrapper>& wrapper) = 0;
 
+    //! \brief Coalesce any chunks that were appended onto the wrapper into one contiguous block.
+    virtual void Compact() = 0;
+
+    //! \brief The number of separate blocks the wrapper's entries are stored in.
+    virtual std::size_t NumChunks() const = 0;
+
     // ========================================
     //  Comparisons.
     // ========================================
 
-    virtual Indicator cmp_less(const std::shared_ptr<Wrapper>& wrapper) const = 0;
-
-    virtual Indicator lt(double value, const IMapType& index_map) const = 0;
-    virtual Indicator gt(double value, const IMapType& index_map) const = 0;
-    virtual Indicator le(double value, const IMapType& index_map) const = 0;
-    virtual Indicator ge(double value, const IMapType& index_map) const = 0;
-    virtual Indicator eq(double value, const IMapType& index_map) const = 0;
-
-    virtual Indicator lt(int value, const IMapType& index_map) const = 0;
-    virtual Indicator gt(int value, const IMapType& index_map) const = 0;
-    virtual Indicator le(int value, const IMapType& index_map) const = 0;
-    virtual Indicator ge(int value, const IMapType& index_map) const = 0;
-    virtual Indicator eq(int value, const IMapType& index_map) const = 0;
-
-    virtual Indicator eq(std::string value, const IMapType& index_map) const = 0;
+    //! \brief Compare the entries of this wrapper (through index_map) with the entries of another wrapper (through
+    //! other_map), entry by entry. Numbers of different types are compared by value. Returns an empty indicator if the
+    //! selections have different sizes, or the entries cannot be compared.
+    virtual Indicator CompareColumn(CompareOp op, const IndexMap& index_map, const Wrapper& other,
+                                    const IndexMap& other_map) const = 0;
+
+    virtual Indicator lt(double value, const IndexMap& index_map) const = 0;
+    virtual Indicator gt(double value, const IndexMap& index_map) const = 0;
+    virtual Indicator le(double value, const IndexMap& index_map) const = 0;
+    virtual Indicator ge(double value, const IndexMap& index_map) const = 0;
+    virtual Indicator eq(double value, const IndexMap& index_map) const = 0;
+    virtual Indicator ne(double value, const IndexMap& index_map) const = 0;
+
+    virtual Indicator lt(int value, const IndexMap& index_map) const = 0;
+    virtual Indicator gt(int value, const IndexMap& index_map) const = 0;
+    virtual Indicator le(int value, const IndexMap& index_map) const = 0;
+    virtual Indicator ge(int value, const IndexMap& index_map) const = 0;
+    virtual Indicator eq(int value, const IndexMap& index_map) const = 0;
+    virtual Indicator ne(int value, const IndexMap& index_map) const = 0;
+
+    virtual Indicator eq(std::string value, const IndexMap& index_map) const = 0;
+    virtual Indicator ne(std::string value, const IndexMap& index_map) const = 0;
+
+    virtual Indicator lt(const Timestamp& value, const IndexMap& index_map) const = 0;
+    virtual Indicator gt(const Timestamp& value, const IndexMap& index_map) const = 0;
+    virtual Indicator le(const Timestamp& value, const IndexMap& index_map) const = 0;
+    virtual Indicator ge(const Timestamp& value, const IndexMap& index_map) const = 0;
+    virtual Indicator eq(const Timestamp& value, const IndexMap& index_map) const = 0;
+    virtual Indicator ne(const Timestamp& value, const IndexMap& index_map) const = 0;
+
+    //! \brief Clear the entries of an indicator for which the corresponding entries of the wrapper (through the index
+    //! map, if there is one) are null, so nulls never satisfy a comparison. Without an index map, the indicator is
+    //! masked with the validity bitmap a word at a time.
+    Indicator MaskNulls(Indicator&& indicator, const IndexMap& index_map) const {
+        if (validity.AllValid() || indicator.empty()) {
+            return std::move(indicator);
+        }
+        if (!index_map.IsFull()) {
+            std::size_t i = 0;
+            index_map.ForEach(indicator.size(), [&](std::size_t index) {
+                if (!validity.IsValid(index)) {
+                    indicator.Set(i, false);
+                }
+                ++i;
+            });
+        }
+        else {
+            const auto& words = validity.Words();
+            auto& output = indicator.Words();
+            for (std::size_t w = 0; w < output.size(); ++w) {
+                output[w] &= words[w];
+            }
+        }
+        return std::move(indicator);
+    }
 
     // ========================================
     //  Casting.
@@ -74,6 +156,15 @@ struct DataFrame::Column::Wrapper {
     virtual std::vector<bool> castToBool() = 0;
     virtual std::vector<float> castToFloat() = 0;
     virtual std::vector<double> castToDouble() = 0;
+
+    //! \brief Write entries [first, first + count) of the view given by the index map into out, as doubles. Null
+    //! entries, and entries that are not numbers, are written as NaN.
+    virtual void ReadDoubles(const IndexMap& index_map, std::size_t first, std::size_t count, double* out) const = 0;
+
+    //! \brief The statistics of the view given by the index map, found in a single pass over the data. Null entries,
+    //! and NaNs, are skipped. Columns that are not numbers have empty statistics. If with_variance is false, the
+    //! variance is not found (it is NaN), which saves a second reduction of each block.
+    virtual Statistics Describe(const IndexMap& index_map, bool with_variance) const = 0;
     virtual std::vector<std::string> castToString() = 0;
 
     // ========================================
@@ -83,6 +174,10 @@ struct DataFrame::Column::Wrapper {
     //! \brief Records whether the wrapper has been orphaned (disconnected from it's
     //! original box).
     bool is_orphan = false;
+
+    //! \brief Which entries of the wrapper are valid, i.e. not null. Every wrapper operation that adds, removes, or
+    //! rearranges entries keeps this in step with the data.
+    ValidityBitmap validity;
 };
 
 #endif // __WRAPPER_TEMPLATES_H__
@@ -0,0 +1,111 @@
+//
+// Created by Nathaniel Rupprecht on 5/18/21.
+//
+
+#include "../include/CSVBatchReader.h"
+
+using namespace dataframe;
+
+CSVBatchReader::CSVBatchReader(std::istream& in, std::size_t batch_size, const CSVOptions& options)
+        : in_(&in), batch_size_(std::max<std::size_t>(1, batch_size)), options_(options),
+          tokenizer_(options.delimiter, options.quote) {
+    ReadHeader();
+}
+
+CSVBatchReader::CSVBatchReader(const std::string& filename, std::size_t batch_size, const CSVOptions& options)
+        : file_(new std::ifstream(filename)), batch_size_(std::max<std::size_t>(1, batch_size)), options_(options),
+          tokenizer_(options.delimiter, options.quote) {
+    if (!file_->fail()) {
+        in_ = file_.get();
+        ReadHeader();
+    }
+}
+
+bool CSVBatchReader::Next(DataFrame& batch) {
+    std::size_t batch_bytes = in_ ? FillBuffer() : 0;
+    if (batch_bytes == 0) {
+        batch = DataFrame();
+        return false;
+    }
+
+    const bool first_batch = !started_;
+    if (first_batch && options_.sample_dtypes) {
+        // Columns that were not given dtypes start out with the dtypes sampled from the first batch.
+        auto field_dtypes = DataFrame::SampleDTypes(buffer_.data(), buffer_.data() + batch_bytes, plan_.columns.size(),
+                                                    options_);
+        for (std::size_t i = 0; i < plan_.columns.size(); ++i) {
+            auto index = plan_.columns[i];
+            if (0 <= index && !plan_.fixed[index]) {
+                dtypes_[index] = field_dtypes[i];
+            }
+        }
+    }
+    started_ = true;
+
+    if (!DataFrame::RecycleStorage(batch.data_, names_, dtypes_)) {
+        batch = DataFrame(DataFrame::MakeStorage(names_, dtypes_));
+    }
+    auto dtypes = dtypes_;
+    DataFrame::ParseRows(buffer_.data(), buffer_.data() + batch_bytes, batch.data_, dtypes, plan_);
+    DataFrame::ReleaseSourceText(batch.data_);
+    DataFrame::DetectCategoricals(batch.data_, options_, plan_.fixed);
+    buffer_.erase(0, batch_bytes);
+
+    // Once a column's dtype has been decided, every later batch starts out with that dtype, and is only converted if
+    // it has a field that does not fit. Any field fits in a string column, so string columns are parsed directly.
+    widened_.clear();
+    std::size_t i = 0;
+    for (const auto& col_pair : batch.data_) {
+        auto dtype = col_pair.second.GetDType();
+        if (!plan_.fixed[i] && dtype != DType::None && dtype != DType::Empty) {
+            if (!first_batch && dtype != dtypes_[i] && dtypes_[i] != DType::None && dtypes_[i] != DType::Empty) {
+                widened_.push_back(names_[i]);
+            }
+            dtypes_[i] = dtype;
+            plan_.fixed[i] = dtype == DType::String || dtype == DType::Categorical;
+        }
+        ++i;
+    }
+    return true;
+}
+
+Schema CSVBatchReader::GetSchema() const {
+    Schema schema;
+    for (std::size_t i = 0; i < names_.size(); ++i) {
+        schema.emplace_back(names_[i], dtypes_[i]);
+    }
+    return schema;
+}
+
+void CSVBatchReader::ReadHeader() {
+    std::string header;
+    tokenizer_.ReadRow(*in_, header);
+    auto names = DataFrame::ReadColumnNames(header, options_);
+    DataFrame::ApplySchemaNames(names, options_);
+    plan_ = DataFrame::MakePlan(names, std::vector<DType>(names.size(), DType::None), options_, names_, dtypes_);
+}
+
+std::size_t CSVBatchReader::FillBuffer() {
+    std::size_t num_rows = 0, position = 0;
+    while (true) {
+        const char *data = buffer_.data(), *end = buffer_.data() + buffer_.size();
+        for (; num_rows < batch_size_; ++num_rows) {
+            // A row whose newline has not been read yet (possibly because it is inside a quoted field) is incomplete.
+            auto newline = tokenizer_.FindRowEnd(data + position, end);
+            if (newline == end) {
+                break;
+            }
+            position = newline + 1 - data;
+        }
+        if (num_rows == batch_size_ || !*in_) {
+            break;
+        }
+        // Read another block from the stream.
+        auto size = buffer_.size();
+        buffer_.resize(size + kBlockSize);
+        in_->read(&buffer_[size], kBlockSize);
+        buffer_.resize(size + static_cast<std::size_t>(in_->gcount()));
+    }
+    // Once the stream is done, the last row does not need to end in a newline.
+    return num_rows < batch_size_ ? buffer_.size() : position;
+}
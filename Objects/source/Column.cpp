@@ -3,6 +3,7 @@
 //
 
 #include "../include/Column.h"
+#include "../include/Expression.h"
 // Other files
 #include <numeric>
 
@@ -13,106 +14,198 @@ namespace dataframe {
     //  Logical operators.
     // ========================================
 
-    Indicator operator<(const Column& col, double rhs) {
-        return col.box_->wrapper_->lt(rhs, col.index_map_);
+    ScalarComparison<double> operator<(const Column& col, double rhs) {
+        return {CompareOp::Lt, col, rhs};
     }
 
-    Indicator operator<(const Column& col, int rhs) {
-        return col.box_->wrapper_->lt(rhs, col.index_map_);
+    ScalarComparison<double> operator<(double rhs, const Column& col) {
+        return {CompareOp::Gt, col, rhs};
     }
 
-    Indicator operator<(double rhs, const Column& col) {
-        return col.box_->wrapper_->gt(rhs, col.index_map_);
+    ScalarComparison<int> operator<(const Column& col, int rhs) {
+        return {CompareOp::Lt, col, rhs};
     }
 
-    Indicator operator<(int rhs, const Column& col) {
-        return col.box_->wrapper_->gt(rhs, col.index_map_);
+    ScalarComparison<int> operator<(int rhs, const Column& col) {
+        return {CompareOp::Gt, col, rhs};
     }
 
-    Indicator operator<=(const Column& col, double rhs) {
-        return col.box_->wrapper_->le(rhs, col.index_map_);
+    ScalarComparison<double> operator<=(const Column& col, double rhs) {
+        return {CompareOp::Le, col, rhs};
     }
 
-    Indicator operator<=(const Column& col, int rhs) {
-        return col.box_->wrapper_->le(rhs, col.index_map_);
+    ScalarComparison<double> operator<=(double rhs, const Column& col) {
+        return {CompareOp::Ge, col, rhs};
     }
 
-    Indicator operator<=(double rhs, const Column& col) {
-        return col.box_->wrapper_->ge(rhs, col.index_map_);
+    ScalarComparison<int> operator<=(const Column& col, int rhs) {
+        return {CompareOp::Le, col, rhs};
     }
 
-    Indicator operator<=(int rhs, const Column& col) {
-        return col.box_->wrapper_->ge(rhs, col.index_map_);
+    ScalarComparison<int> operator<=(int rhs, const Column& col) {
+        return {CompareOp::Ge, col, rhs};
     }
 
-    Indicator operator>(const Column& col, double rhs) {
-        return rhs < col;
+    ScalarComparison<double> operator>(const Column& col, double rhs) {
+        return {CompareOp::Gt, col, rhs};
     }
 
-    Indicator operator>(const Column& col, int rhs) {
-        return rhs < col;
+    ScalarComparison<double> operator>(double rhs, const Column& col) {
+        return {CompareOp::Lt, col, rhs};
     }
 
-    Indicator operator>(double rhs, const Column& col) {
-        return col < rhs;
+    ScalarComparison<int> operator>(const Column& col, int rhs) {
+        return {CompareOp::Gt, col, rhs};
     }
 
-    Indicator operator>(int rhs, const Column& col) {
-        return col < rhs;
+    ScalarComparison<int> operator>(int rhs, const Column& col) {
+        return {CompareOp::Lt, col, rhs};
     }
 
-    Indicator operator>=(const Column& col, double rhs) {
-        return rhs <= col;
+    ScalarComparison<double> operator>=(const Column& col, double rhs) {
+        return {CompareOp::Ge, col, rhs};
     }
 
-    Indicator operator>=(const Column& col, int rhs) {
-        return rhs <= col;
+    ScalarComparison<double> operator>=(double rhs, const Column& col) {
+        return {CompareOp::Le, col, rhs};
     }
 
-    Indicator operator>=(double rhs, const Column& col) {
-        return col <= rhs;
+    ScalarComparison<int> operator>=(const Column& col, int rhs) {
+        return {CompareOp::Ge, col, rhs};
     }
 
-    Indicator operator>=(int rhs, const Column& col) {
-        return col <= rhs;
+    ScalarComparison<int> operator>=(int rhs, const Column& col) {
+        return {CompareOp::Le, col, rhs};
     }
 
-    Indicator operator==(const Column& col, double rhs) {
-        return col.box_->wrapper_->eq(rhs, col.index_map_);
+    ScalarComparison<double> operator==(const Column& col, double rhs) {
+        return {CompareOp::Eq, col, rhs};
     }
 
-    Indicator operator==(const Column& col, int rhs) {
-        return col.box_->wrapper_->eq(rhs, col.index_map_);
+    ScalarComparison<double> operator==(double rhs, const Column& col) {
+        return {CompareOp::Eq, col, rhs};
     }
 
-    Indicator operator==(double rhs, const Column& col) {
-        return col == rhs;
+    ScalarComparison<int> operator==(const Column& col, int rhs) {
+        return {CompareOp::Eq, col, rhs};
     }
 
-    Indicator operator==(int rhs, const Column& col) {
-        return col == rhs;
+    ScalarComparison<int> operator==(int rhs, const Column& col) {
+        return {CompareOp::Eq, col, rhs};
     }
 
-    Indicator operator==(const std::string& rhs, const Column& col) {
-        return col.box_->wrapper_->eq(rhs, col.index_map_);
+    ScalarComparison<std::string> operator==(const std::string& rhs, const Column& col) {
+        return {CompareOp::Eq, col, rhs};
     }
 
-    Indicator operator==(const Column& col, const std::string& rhs) {
-        return col.box_->wrapper_->eq(rhs, col.index_map_);
+    ScalarComparison<std::string> operator==(const Column& col, const std::string& rhs) {
+        return {CompareOp::Eq, col, rhs};
+    }
+
+    ScalarComparison<double> operator!=(const Column& col, double rhs) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<double> operator!=(double rhs, const Column& col) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<int> operator!=(const Column& col, int rhs) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<int> operator!=(int rhs, const Column& col) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<std::string> operator!=(const std::string& rhs, const Column& col) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<std::string> operator!=(const Column& col, const std::string& rhs) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator<(const Column& col, const Timestamp& rhs) {
+        return {CompareOp::Lt, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator<(const Timestamp& rhs, const Column& col) {
+        return {CompareOp::Gt, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator<=(const Column& col, const Timestamp& rhs) {
+        return {CompareOp::Le, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator<=(const Timestamp& rhs, const Column& col) {
+        return {CompareOp::Ge, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator>(const Column& col, const Timestamp& rhs) {
+        return {CompareOp::Gt, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator>(const Timestamp& rhs, const Column& col) {
+        return {CompareOp::Lt, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator>=(const Column& col, const Timestamp& rhs) {
+        return {CompareOp::Ge, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator>=(const Timestamp& rhs, const Column& col) {
+        return {CompareOp::Le, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator==(const Column& col, const Timestamp& rhs) {
+        return {CompareOp::Eq, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator==(const Timestamp& rhs, const Column& col) {
+        return {CompareOp::Eq, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator!=(const Column& col, const Timestamp& rhs) {
+        return {CompareOp::Ne, col, rhs};
+    }
+
+    ScalarComparison<Timestamp> operator!=(const Timestamp& rhs, const Column& col) {
+        return {CompareOp::Ne, col, rhs};
     }
 
     Indicator operator<(const Column& colA, const Column& colB) {
-        // \TODO: Work with index map.
-        return colA.box_->wrapper_->cmp_less(colB.box_->wrapper_);
+        return colA.box_->wrapper_->CompareColumn(
+                CompareOp::Lt, colA.index_map_, *colB.box_->wrapper_, colB.index_map_);
+    }
+
+    Indicator operator<=(const Column& colA, const Column& colB) {
+        return colA.box_->wrapper_->CompareColumn(
+                CompareOp::Le, colA.index_map_, *colB.box_->wrapper_, colB.index_map_);
     }
 
     Indicator operator>(const Column& colA, const Column& colB) {
         return colB < colA;
     }
 
-    bool Column::operator==(const DataFrame::Column& rhs) {
-        // If both columns are references to the same data, their data is necessarily equal.
-        if (IsRefOf(rhs)) {
+    Indicator operator>=(const Column& colA, const Column& colB) {
+        return colB <= colA;
+    }
+
+    Indicator operator==(const Column& colA, const Column& colB) {
+        return colA.box_->wrapper_->CompareColumn(
+                CompareOp::Eq, colA.index_map_, *colB.box_->wrapper_, colB.index_map_);
+    }
+
+    Indicator operator!=(const Column& colA, const Column& colB) {
+        return colA.box_->wrapper_->CompareColumn(
+                CompareOp::Ne, colA.index_map_, *colB.box_->wrapper_, colB.index_map_);
+    }
+
+    bool Column::Equals(const DataFrame::Column& rhs) const {
+        // If both columns hold the same data (references, or clones that have not been written to), their data is
+        // necessarily equal.
+        if (box_->wrapper_ == rhs.box_->wrapper_) {
             return true;
         } else {
             return box_->wrapper_->CheckEquals(rhs.box_->wrapper_);
@@ -132,11 +225,12 @@ namespace dataframe {
             throw std::exception();
         }
         // Copy data if the types are the same.
+        box_->Own();
         if (!box_->wrapper_->Copy(rhs.box_->wrapper_)) {
             if (IsFullColumn()) {
-                // Types were not the same. Need to retype.
-                box_->wrapper_->is_orphan = true;
-                box_->wrapper_ = rhs.box_->wrapper_->Clone();
+                // Types were not the same. Need to retype. The column shares the other column's data until one of them
+                // is written to.
+                box_->ShareWith(*rhs.box_);
             }
             else {
                 // Can't change the type of a column that isn't a full column.
@@ -147,7 +241,7 @@ namespace dataframe {
     }
 
     bool Column::IsRefOf(const DataFrame::Column& rhs) const {
-        return box_->wrapper_ == rhs.box_->wrapper_;
+        return box_ == rhs.box_;
     }
 
     bool Column::SameTypeAs(const DataFrame::Column& rhs) const {
@@ -160,24 +254,22 @@ namespace dataframe {
 
     Column Column::Clone() const {
         Column col(DType::None);
-        col.box_ = std::make_shared<Box>(box_->Clone());
+        if (!index_map_.IsFull()) {
+            // Only the selected entries are cloned.
+            col.box_ = std::make_shared<Box>(box_->wrapper_->Clone(index_map_));
+        }
+        else {
+            col.box_ = std::make_shared<Box>(box_->Share());
+        }
         return col;
     }
 
     std::size_t Column::Size() const {
-        if (index_map_) {
-            return index_map_->size();
-        } else {
-            return box_->wrapper_->Size();
-        }
+        return index_map_.Size(box_->wrapper_->Size());
     }
 
     bool Column::Empty() const {
-        if (index_map_) {
-            return index_map_->empty();
-        } else {
-            return box_->wrapper_->Empty();
-        }
+        return Size() == 0;
     }
 
     DType Column::GetDType() const {
@@ -185,14 +277,81 @@ namespace dataframe {
     }
 
     void Column::ToStream(std::size_t index, std::ostream& out) const {
-        if (index_map_) {
-            box_->wrapper_->ToStream((*index_map_)[index], out);
-        } else {
-            box_->wrapper_->ToStream(index, out);
+        box_->wrapper_->ToStream(index_map_[index], out);
+    }
+
+    bool Column::IsNull(std::size_t index) const {
+        return !box_->wrapper_->validity.IsValid(index_map_[index]);
+    }
+
+    void Column::ReadDoubles(std::size_t first, std::size_t count, double* out) const {
+        box_->wrapper_->ReadDoubles(index_map_, first, count, out);
+    }
+
+    void Column::ReadValidity(std::size_t first, std::size_t count, std::uint64_t* out) const {
+        const auto& validity = box_->wrapper_->validity;
+        const auto num_words = ValidityBitmap::WordsFor(count);
+        if (validity.AllValid()) {
+            std::fill(out, out + num_words, ~std::uint64_t(0));
+            if (count & 63) {
+                out[num_words - 1] = (std::uint64_t(1) << (count & 63)) - 1;
+            }
+            return;
         }
+        std::fill(out, out + num_words, 0);
+        std::size_t i = 0;
+        index_map_.ForEach(first, first + count, [&](std::size_t index) {
+            out[i >> 6] |= static_cast<std::uint64_t>(validity.IsValid(index)) << (i & 63);
+            ++i;
+        });
+    }
+
+    Statistics Column::Describe() const {
+        return box_->wrapper_->Describe(index_map_, true);
+    }
+
+    double Column::Sum() const {
+        return box_->wrapper_->Describe(index_map_, false).sum;
+    }
+
+    double Column::Mean() const {
+        return box_->wrapper_->Describe(index_map_, false).mean;
+    }
+
+    double Column::Min() const {
+        return box_->wrapper_->Describe(index_map_, false).min;
+    }
+
+    double Column::Max() const {
+        return box_->wrapper_->Describe(index_map_, false).max;
     }
 
-    DataFrame::Column::Column(DType dtype, IMapType index_map, std::size_t size)
+    double Column::Var() const {
+        return Describe().variance;
+    }
+
+    std::size_t Column::Count() const {
+        // Only floating point columns can hold NaNs.
+        const auto dtype = GetDType();
+        if (dtype == DType::Float || dtype == DType::Double) {
+            return box_->wrapper_->Describe(index_map_, false).count;
+        }
+        return Size() - NullCount();
+    }
+
+    std::size_t Column::NullCount() const {
+        const auto& validity = box_->wrapper_->validity;
+        if (index_map_.IsFull() || validity.AllValid()) {
+            return validity.NullCount();
+        }
+        std::size_t count = 0;
+        index_map_.ForEach(index_map_.Size(), [&](std::size_t index) {
+            count += !validity.IsValid(index);
+        });
+        return count;
+    }
+
+    DataFrame::Column::Column(DType dtype, IndexMap index_map, std::size_t size)
     : index_map_(std::move(index_map)) {
         switch (dtype) {
             case DType::None:
@@ -216,6 +375,33 @@ namespace dataframe {
             case DType::String:
                 box_ = Box::MakeBox<std::string>(size);
                 break;
+            case DType::Categorical:
+                box_ = Box::MakeBox<Categorical>(size);
+                break;
+            case DType::Timestamp:
+                box_ = Box::MakeBox<Timestamp>(size);
+                break;
+            case DType::Int8:
+                box_ = Box::MakeBox<std::int8_t>(size);
+                break;
+            case DType::Int16:
+                box_ = Box::MakeBox<std::int16_t>(size);
+                break;
+            case DType::Int64:
+                box_ = Box::MakeBox<std::int64_t>(size);
+                break;
+            case DType::UInt8:
+                box_ = Box::MakeBox<std::uint8_t>(size);
+                break;
+            case DType::UInt16:
+                box_ = Box::MakeBox<std::uint16_t>(size);
+                break;
+            case DType::UInt32:
+                box_ = Box::MakeBox<std::uint32_t>(size);
+                break;
+            case DType::UInt64:
+                box_ = Box::MakeBox<std::uint64_t>(size);
+                break;
             default:
                 throw std::exception();
         }
@@ -223,9 +409,22 @@ namespace dataframe {
 
     bool Column::Append(const Column& col) {
         // Note: This function does not update the index map, DataFrame will take care of that.
+        box_->Own();
+        if (!col.index_map_.IsFull()) {
+            // Only append the entries that the other column selects.
+            return box_->wrapper_->Append(col.box_->wrapper_->Clone(col.index_map_));
+        }
         return box_->wrapper_->Append(col.box_->wrapper_);
     }
 
+    void Column::Compact() {
+        box_->Compact();
+    }
+
+    std::size_t Column::NumChunks() const {
+        return box_->wrapper_->NumChunks();
+    }
+
     std::size_t Column::FullSize() const {
         return box_->wrapper_->Size();
     }
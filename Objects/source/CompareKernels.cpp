@@ -0,0 +1,646 @@
+//
+// Created by Nathaniel Rupprecht on 6/5/21.
+//
+
+#include "../include/CompareKernels.h"
+// Other files
+#include <type_traits>
+
+#if defined(__x86_64__)
+#define DATAFRAME_X86_SIMD
+#include <immintrin.h>
+//! \brief Compile a function for AVX2, whether or not the rest of the library is. It is only called if the processor
+//! has AVX2.
+#define DATAFRAME_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace dataframe;
+using namespace dataframe::kernels;
+
+namespace {
+
+    template<CompareOp op>
+    using OpTag = std::integral_constant<CompareOp, op>;
+
+    //! \brief Call f with a tag for the comparison, so the comparison is a template parameter of the kernel, and is
+    //! not decided again for every entry.
+    template<typename Function>
+    void WithOp(CompareOp op, Function &&f) {
+        switch (op) {
+            case CompareOp::Lt:
+                return f(OpTag<CompareOp::Lt>());
+            case CompareOp::Gt:
+                return f(OpTag<CompareOp::Gt>());
+            case CompareOp::Le:
+                return f(OpTag<CompareOp::Le>());
+            case CompareOp::Ge:
+                return f(OpTag<CompareOp::Ge>());
+            case CompareOp::Eq:
+                return f(OpTag<CompareOp::Eq>());
+            case CompareOp::Ne:
+                return f(OpTag<CompareOp::Ne>());
+        }
+    }
+
+    template<CompareOp op, typename T, typename V>
+    inline bool Apply(T x, V v) {
+        if constexpr (op == CompareOp::Lt) {
+            return x < v;
+        }
+        else if constexpr (op == CompareOp::Gt) {
+            return x > v;
+        }
+        else if constexpr (op == CompareOp::Le) {
+            return x <= v;
+        }
+        else if constexpr (op == CompareOp::Ge) {
+            return x >= v;
+        }
+        else if constexpr (op == CompareOp::Eq) {
+            return x == v;
+        }
+        else {
+            return x != v;
+        }
+    }
+
+    // ========================================
+    //  Plain loops.
+    // ========================================
+
+    //! \brief Compare the entries [first, size) of the data, where first is a multiple of 64.
+    template<CompareOp op, typename T, typename V>
+    void ScalarCompare(const T *data, std::size_t first, std::size_t size, V value, std::uint64_t *out) {
+        for (std::size_t i = first; i < size; i += 64) {
+            std::uint64_t word = 0;
+            const auto count = size - i < 64 ? size - i : 64;
+            for (std::size_t j = 0; j < count; ++j) {
+                word |= static_cast<std::uint64_t>(Apply<op>(static_cast<V>(data[i + j]), value)) << j;
+            }
+            out[i >> 6] = word;
+        }
+    }
+
+    //! \brief Compare the entries of the data at indices [first, size), where first is a multiple of 64.
+    template<CompareOp op, typename T, typename V>
+    void ScalarGather(const T *data, const std::size_t *indices, std::size_t first, std::size_t size, V value,
+                      std::uint64_t *out) {
+        for (std::size_t i = first; i < size; i += 64) {
+            std::uint64_t word = 0;
+            const auto count = size - i < 64 ? size - i : 64;
+            for (std::size_t j = 0; j < count; ++j) {
+                word |= static_cast<std::uint64_t>(Apply<op>(static_cast<V>(data[indices[i + j]]), value)) << j;
+            }
+            out[i >> 6] = word;
+        }
+    }
+
+    //! \brief The type that entries of types L and R are compared in.
+    template<typename L, typename R>
+    using PromotedType = std::conditional_t<std::is_same<L, R>::value, L, double>;
+
+    //! \brief Compare entries [first, size) of two arrays, where first is a multiple of 64.
+    template<CompareOp op, typename L, typename R>
+    void ScalarColumns(const L *lhs, const R *rhs, std::size_t first, std::size_t size, std::uint64_t *out) {
+        using C = PromotedType<L, R>;
+        for (std::size_t i = first; i < size; i += 64) {
+            std::uint64_t word = 0;
+            const auto count = size - i < 64 ? size - i : 64;
+            for (std::size_t j = 0; j < count; ++j) {
+                word |= static_cast<std::uint64_t>(
+                        Apply<op>(static_cast<C>(lhs[i + j]), static_cast<C>(rhs[i + j]))) << j;
+            }
+            out[i >> 6] = word;
+        }
+    }
+
+    //! \brief Compare the entries of two arrays at pairs of indices.
+    template<CompareOp op, typename L, typename R>
+    void ScalarColumnsGather(const L *lhs, const std::size_t *lhs_indices, const R *rhs,
+                             const std::size_t *rhs_indices, std::size_t size, std::uint64_t *out) {
+        using C = PromotedType<L, R>;
+        for (std::size_t i = 0; i < size; i += 64) {
+            std::uint64_t word = 0;
+            const auto count = size - i < 64 ? size - i : 64;
+            for (std::size_t j = 0; j < count; ++j) {
+                word |= static_cast<std::uint64_t>(Apply<op>(static_cast<C>(lhs[lhs_indices[i + j]]),
+                                                             static_cast<C>(rhs[rhs_indices[i + j]]))) << j;
+            }
+            out[i >> 6] = word;
+        }
+    }
+
+#ifdef DATAFRAME_X86_SIMD
+
+    //! \brief Integer SIMD instructions only compare for <, >, and ==. The other comparisons are the negations of
+    //! these.
+    template<CompareOp op>
+    constexpr bool kIntInverted = op == CompareOp::Le || op == CompareOp::Ge || op == CompareOp::Ne;
+
+    //! \brief The predicate for the AVX comparison instructions. These are the ordered predicates, except for !=, so
+    //! NaNs compare the same as they do in C++.
+    template<CompareOp op>
+    constexpr int kAvxPredicate = op == CompareOp::Lt ? _CMP_LT_OQ
+                                : op == CompareOp::Gt ? _CMP_GT_OQ
+                                : op == CompareOp::Le ? _CMP_LE_OQ
+                                : op == CompareOp::Ge ? _CMP_GE_OQ
+                                : op == CompareOp::Eq ? _CMP_EQ_OQ
+                                : _CMP_NEQ_UQ;
+
+    // ========================================
+    //  SSE2. Every x86-64 processor has this.
+    // ========================================
+
+    template<CompareOp op>
+    inline __m128d Sse2Cmp(__m128d x, __m128d v) {
+        if constexpr (op == CompareOp::Lt) {
+            return _mm_cmplt_pd(x, v);
+        }
+        else if constexpr (op == CompareOp::Gt) {
+            return _mm_cmpgt_pd(x, v);
+        }
+        else if constexpr (op == CompareOp::Le) {
+            return _mm_cmple_pd(x, v);
+        }
+        else if constexpr (op == CompareOp::Ge) {
+            return _mm_cmpge_pd(x, v);
+        }
+        else if constexpr (op == CompareOp::Eq) {
+            return _mm_cmpeq_pd(x, v);
+        }
+        else {
+            return _mm_cmpneq_pd(x, v);
+        }
+    }
+
+    template<CompareOp op>
+    inline __m128 Sse2Cmp(__m128 x, __m128 v) {
+        if constexpr (op == CompareOp::Lt) {
+            return _mm_cmplt_ps(x, v);
+        }
+        else if constexpr (op == CompareOp::Gt) {
+            return _mm_cmpgt_ps(x, v);
+        }
+        else if constexpr (op == CompareOp::Le) {
+            return _mm_cmple_ps(x, v);
+        }
+        else if constexpr (op == CompareOp::Ge) {
+            return _mm_cmpge_ps(x, v);
+        }
+        else if constexpr (op == CompareOp::Eq) {
+            return _mm_cmpeq_ps(x, v);
+        }
+        else {
+            return _mm_cmpneq_ps(x, v);
+        }
+    }
+
+    //! \brief Compare integers for <, >, or ==. The result has to be inverted for the other comparisons.
+    template<CompareOp op>
+    inline __m128i Sse2Cmp(__m128i x, __m128i v) {
+        if constexpr (op == CompareOp::Lt || op == CompareOp::Ge) {
+            return _mm_cmplt_epi32(x, v);
+        }
+        else if constexpr (op == CompareOp::Gt || op == CompareOp::Le) {
+            return _mm_cmpgt_epi32(x, v);
+        }
+        else {
+            return _mm_cmpeq_epi32(x, v);
+        }
+    }
+
+    template<CompareOp op>
+    void Sse2Compare(const double *data, std::size_t num_words, double value, std::uint64_t *out) {
+        const auto v = _mm_set1_pd(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 2) {
+                auto mask = Sse2Cmp<op>(_mm_loadu_pd(data + j), v);
+                word |= static_cast<std::uint64_t>(_mm_movemask_pd(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    void Sse2Compare(const float *data, std::size_t num_words, float value, std::uint64_t *out) {
+        const auto v = _mm_set1_ps(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto mask = Sse2Cmp<op>(_mm_loadu_ps(data + j), v);
+                word |= static_cast<std::uint64_t>(_mm_movemask_ps(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    void Sse2Compare(const std::int32_t *data, std::size_t num_words, std::int32_t value, std::uint64_t *out) {
+        const auto v = _mm_set1_epi32(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto mask = Sse2Cmp<op>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + j)), v);
+                word |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(mask))) << j;
+            }
+            out[w] = kIntInverted<op> ? ~word : word;
+        }
+    }
+
+    template<CompareOp op>
+    void Sse2Compare(const std::int32_t *data, std::size_t num_words, double value, std::uint64_t *out) {
+        // Every int32 is exactly representable as a double.
+        const auto v = _mm_set1_pd(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 2) {
+                auto x = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(data + j)));
+                word |= static_cast<std::uint64_t>(_mm_movemask_pd(Sse2Cmp<op>(x, v))) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    //! \brief Load two entries as doubles.
+    inline __m128d Sse2LoadPd(const double *p) {
+        return _mm_loadu_pd(p);
+    }
+
+    inline __m128d Sse2LoadPd(const float *p) {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))));
+    }
+
+    inline __m128d Sse2LoadPd(const std::int32_t *p) {
+        return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)));
+    }
+
+    //! \brief Compare two arrays of different types, as doubles.
+    template<CompareOp op, typename L, typename R>
+    void Sse2Columns(const L *lhs, const R *rhs, std::size_t num_words, std::uint64_t *out) {
+        for (std::size_t w = 0; w < num_words; ++w, lhs += 64, rhs += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 2) {
+                auto mask = Sse2Cmp<op>(Sse2LoadPd(lhs + j), Sse2LoadPd(rhs + j));
+                word |= static_cast<std::uint64_t>(_mm_movemask_pd(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    void Sse2Columns(const float *lhs, const float *rhs, std::size_t num_words, std::uint64_t *out) {
+        for (std::size_t w = 0; w < num_words; ++w, lhs += 64, rhs += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto mask = Sse2Cmp<op>(_mm_loadu_ps(lhs + j), _mm_loadu_ps(rhs + j));
+                word |= static_cast<std::uint64_t>(_mm_movemask_ps(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    void Sse2Columns(const std::int32_t *lhs, const std::int32_t *rhs, std::size_t num_words, std::uint64_t *out) {
+        for (std::size_t w = 0; w < num_words; ++w, lhs += 64, rhs += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto mask = Sse2Cmp<op>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + j)),
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + j)));
+                word |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(mask))) << j;
+            }
+            out[w] = kIntInverted<op> ? ~word : word;
+        }
+    }
+
+    // ========================================
+    //  AVX2.
+    // ========================================
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Compare(const double *data, std::size_t num_words, double value, std::uint64_t *out) {
+        const auto v = _mm256_set1_pd(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto mask = _mm256_cmp_pd(_mm256_loadu_pd(data + j), v, kAvxPredicate<op>);
+                word |= static_cast<std::uint64_t>(_mm256_movemask_pd(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Compare(const float *data, std::size_t num_words, float value, std::uint64_t *out) {
+        const auto v = _mm256_set1_ps(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 8) {
+                auto mask = _mm256_cmp_ps(_mm256_loadu_ps(data + j), v, kAvxPredicate<op>);
+                word |= static_cast<std::uint64_t>(_mm256_movemask_ps(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Compare(const std::int32_t *data, std::size_t num_words, std::int32_t value,
+                                    std::uint64_t *out) {
+        const auto v = _mm256_set1_epi32(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 8) {
+                auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + j));
+                __m256i mask;
+                if constexpr (op == CompareOp::Lt || op == CompareOp::Ge) {
+                    mask = _mm256_cmpgt_epi32(v, x);
+                }
+                else if constexpr (op == CompareOp::Gt || op == CompareOp::Le) {
+                    mask = _mm256_cmpgt_epi32(x, v);
+                }
+                else {
+                    mask = _mm256_cmpeq_epi32(x, v);
+                }
+                word |= static_cast<std::uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(mask))) << j;
+            }
+            out[w] = kIntInverted<op> ? ~word : word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Compare(const std::int32_t *data, std::size_t num_words, double value,
+                                    std::uint64_t *out) {
+        const auto v = _mm256_set1_pd(value);
+        for (std::size_t w = 0; w < num_words; ++w, data += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto x = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + j)));
+                word |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(x, v, kAvxPredicate<op>))) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    //! \brief Load four indices for a gather instruction.
+    DATAFRAME_AVX2 inline __m256i LoadIndices(const std::size_t *indices) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices));
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Gather(const double *data, const std::size_t *indices, std::size_t num_words,
+                                   double value, std::uint64_t *out) {
+        const auto v = _mm256_set1_pd(value);
+        for (std::size_t w = 0; w < num_words; ++w, indices += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto x = _mm256_i64gather_pd(data, LoadIndices(indices + j), 8);
+                word |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(x, v, kAvxPredicate<op>))) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Gather(const float *data, const std::size_t *indices, std::size_t num_words,
+                                   float value, std::uint64_t *out) {
+        const auto v = _mm_set1_ps(value);
+        for (std::size_t w = 0; w < num_words; ++w, indices += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto x = _mm256_i64gather_ps(data, LoadIndices(indices + j), 4);
+                word |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_cmp_ps(x, v, kAvxPredicate<op>))) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Gather(const std::int32_t *data, const std::size_t *indices, std::size_t num_words,
+                                   std::int32_t value, std::uint64_t *out) {
+        const auto v = _mm_set1_epi32(value);
+        for (std::size_t w = 0; w < num_words; ++w, indices += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto x = _mm256_i64gather_epi32(reinterpret_cast<const int *>(data), LoadIndices(indices + j), 4);
+                word |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(Sse2Cmp<op>(x, v)))) << j;
+            }
+            out[w] = kIntInverted<op> ? ~word : word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Gather(const std::int32_t *data, const std::size_t *indices, std::size_t num_words,
+                                   double value, std::uint64_t *out) {
+        const auto v = _mm256_set1_pd(value);
+        for (std::size_t w = 0; w < num_words; ++w, indices += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto x = _mm256_cvtepi32_pd(
+                        _mm256_i64gather_epi32(reinterpret_cast<const int *>(data), LoadIndices(indices + j), 4));
+                word |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(x, v, kAvxPredicate<op>))) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    //! \brief Load four entries as doubles.
+    DATAFRAME_AVX2 inline __m256d Avx2LoadPd(const double *p) {
+        return _mm256_loadu_pd(p);
+    }
+
+    DATAFRAME_AVX2 inline __m256d Avx2LoadPd(const float *p) {
+        return _mm256_cvtps_pd(_mm_loadu_ps(p));
+    }
+
+    DATAFRAME_AVX2 inline __m256d Avx2LoadPd(const std::int32_t *p) {
+        return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+    }
+
+    //! \brief Compare two arrays of different types, as doubles.
+    template<CompareOp op, typename L, typename R>
+    DATAFRAME_AVX2 void Avx2Columns(const L *lhs, const R *rhs, std::size_t num_words, std::uint64_t *out) {
+        for (std::size_t w = 0; w < num_words; ++w, lhs += 64, rhs += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 4) {
+                auto mask = _mm256_cmp_pd(Avx2LoadPd(lhs + j), Avx2LoadPd(rhs + j), kAvxPredicate<op>);
+                word |= static_cast<std::uint64_t>(_mm256_movemask_pd(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Columns(const float *lhs, const float *rhs, std::size_t num_words, std::uint64_t *out) {
+        for (std::size_t w = 0; w < num_words; ++w, lhs += 64, rhs += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 8) {
+                auto mask = _mm256_cmp_ps(_mm256_loadu_ps(lhs + j), _mm256_loadu_ps(rhs + j), kAvxPredicate<op>);
+                word |= static_cast<std::uint64_t>(_mm256_movemask_ps(mask)) << j;
+            }
+            out[w] = word;
+        }
+    }
+
+    template<CompareOp op>
+    DATAFRAME_AVX2 void Avx2Columns(const std::int32_t *lhs, const std::int32_t *rhs, std::size_t num_words,
+                                    std::uint64_t *out) {
+        for (std::size_t w = 0; w < num_words; ++w, lhs += 64, rhs += 64) {
+            std::uint64_t word = 0;
+            for (std::size_t j = 0; j < 64; j += 8) {
+                auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + j));
+                auto y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + j));
+                __m256i mask;
+                if constexpr (op == CompareOp::Lt || op == CompareOp::Ge) {
+                    mask = _mm256_cmpgt_epi32(y, x);
+                }
+                else if constexpr (op == CompareOp::Gt || op == CompareOp::Le) {
+                    mask = _mm256_cmpgt_epi32(x, y);
+                }
+                else {
+                    mask = _mm256_cmpeq_epi32(x, y);
+                }
+                word |= static_cast<std::uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(mask))) << j;
+            }
+            out[w] = kIntInverted<op> ? ~word : word;
+        }
+    }
+
+#endif // DATAFRAME_X86_SIMD
+
+    //! \brief Compare contiguous data, with whole words of results done by the best kernel for the machine, and the
+    //! rest done by a plain loop.
+    template<CompareOp op, typename T, typename V>
+    void Contiguous(const T *data, std::size_t size, V value, std::uint64_t *out) {
+        const auto num_words = size / 64;
+#ifdef DATAFRAME_X86_SIMD
+        switch (GetSimdLevel()) {
+            case SimdLevel::AVX2:
+                Avx2Compare<op>(data, num_words, value, out);
+                break;
+            case SimdLevel::SSE2:
+                Sse2Compare<op>(data, num_words, value, out);
+                break;
+            default:
+                ScalarCompare<op>(data, 0, 64 * num_words, value, out);
+                break;
+        }
+#else
+        ScalarCompare<op>(data, 0, 64 * num_words, value, out);
+#endif
+        ScalarCompare<op>(data, 64 * num_words, size, value, out);
+    }
+
+    //! \brief Compare data through indices. Only AVX2 has gather instructions, so other machines use a plain loop.
+    template<CompareOp op, typename T, typename V>
+    void Gather(const T *data, const std::size_t *indices, std::size_t size, V value, std::uint64_t *out) {
+        std::size_t first = 0;
+#ifdef DATAFRAME_X86_SIMD
+        if (GetSimdLevel() == SimdLevel::AVX2) {
+            Avx2Gather<op>(data, indices, size / 64, value, out);
+            first = size / 64 * 64;
+        }
+#endif
+        ScalarGather<op>(data, indices, first, size, value, out);
+    }
+
+    //! \brief Compare two contiguous arrays, with whole words of results done by the best kernel for the machine.
+    template<CompareOp op, typename L, typename R>
+    void ContiguousColumns(const L *lhs, const R *rhs, std::size_t size, std::uint64_t *out) {
+        const auto num_words = size / 64;
+#ifdef DATAFRAME_X86_SIMD
+        switch (GetSimdLevel()) {
+            case SimdLevel::AVX2:
+                Avx2Columns<op>(lhs, rhs, num_words, out);
+                break;
+            case SimdLevel::SSE2:
+                Sse2Columns<op>(lhs, rhs, num_words, out);
+                break;
+            default:
+                ScalarColumns<op>(lhs, rhs, 0, 64 * num_words, out);
+                break;
+        }
+#else
+        ScalarColumns<op>(lhs, rhs, 0, 64 * num_words, out);
+#endif
+        ScalarColumns<op>(lhs, rhs, 64 * num_words, size, out);
+    }
+}
+
+SimdLevel kernels::GetSimdLevel() {
+    static const SimdLevel level = [] {
+#ifdef DATAFRAME_X86_SIMD
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") ? SimdLevel::AVX2 : SimdLevel::SSE2;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }();
+    return level;
+}
+
+void kernels::Compare(CompareOp op, const std::int32_t* data, std::size_t size, std::int32_t value,
+                      std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Contiguous<decltype(tag)::value>(data, size, value, out); });
+}
+
+void kernels::Compare(CompareOp op, const std::int32_t* data, std::size_t size, double value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Contiguous<decltype(tag)::value>(data, size, value, out); });
+}
+
+void kernels::Compare(CompareOp op, const float* data, std::size_t size, float value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Contiguous<decltype(tag)::value>(data, size, value, out); });
+}
+
+void kernels::Compare(CompareOp op, const double* data, std::size_t size, double value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Contiguous<decltype(tag)::value>(data, size, value, out); });
+}
+
+void kernels::CompareGather(CompareOp op, const std::int32_t* data, const std::size_t* indices, std::size_t size,
+                            std::int32_t value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Gather<decltype(tag)::value>(data, indices, size, value, out); });
+}
+
+void kernels::CompareGather(CompareOp op, const std::int32_t* data, const std::size_t* indices, std::size_t size,
+                            double value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Gather<decltype(tag)::value>(data, indices, size, value, out); });
+}
+
+void kernels::CompareGather(CompareOp op, const float* data, const std::size_t* indices, std::size_t size,
+                            float value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Gather<decltype(tag)::value>(data, indices, size, value, out); });
+}
+
+void kernels::CompareGather(CompareOp op, const double* data, const std::size_t* indices, std::size_t size,
+                            double value, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { Gather<decltype(tag)::value>(data, indices, size, value, out); });
+}
+
+template<typename L, typename R>
+void kernels::CompareColumns(CompareOp op, const L* lhs, const R* rhs, std::size_t size, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) { ContiguousColumns<decltype(tag)::value>(lhs, rhs, size, out); });
+}
+
+template<typename L, typename R>
+void kernels::CompareColumnsGather(CompareOp op, const L* lhs, const std::size_t* lhs_indices, const R* rhs,
+                                   const std::size_t* rhs_indices, std::size_t size, std::uint64_t* out) {
+    WithOp(op, [&](auto tag) {
+        ScalarColumnsGather<decltype(tag)::value>(lhs, lhs_indices, rhs, rhs_indices, size, out);
+    });
+}
+
+#define DATAFRAME_COLUMN_KERNELS(L, R) \
+    template void kernels::CompareColumns<L, R>(CompareOp, const L*, const R*, std::size_t, std::uint64_t*); \
+    template void kernels::CompareColumnsGather<L, R>( \
+            CompareOp, const L*, const std::size_t*, const R*, const std::size_t*, std::size_t, std::uint64_t*);
+
+DATAFRAME_COLUMN_KERNELS(std::int32_t, std::int32_t)
+DATAFRAME_COLUMN_KERNELS(std::int32_t, float)
+DATAFRAME_COLUMN_KERNELS(std::int32_t, double)
+DATAFRAME_COLUMN_KERNELS(float, std::int32_t)
+DATAFRAME_COLUMN_KERNELS(float, float)
+DATAFRAME_COLUMN_KERNELS(float, double)
+DATAFRAME_COLUMN_KERNELS(double, std::int32_t)
+DATAFRAME_COLUMN_KERNELS(double, float)
+DATAFRAME_COLUMN_KERNELS(double, double)
+
+#undef DATAFRAME_COLUMN_KERNELS
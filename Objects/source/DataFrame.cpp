@@ -8,12 +8,47 @@
 #include <sstream>
 #include "../include/TypeConversion.h"
 #include "../include/Column.h"
+#include "../include/MemoryMap.h"
+#include "../include/CSVTokenizer.h"
+#include "../include/Concrete.h"
 
 #include <iostream>
 #include <utility>
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <iterator>
+#include <unordered_set>
+#include <cstring>
+#include <cstdint>
 
 using namespace dataframe;
 
+namespace {
+    //! \brief Marks the beginning and the end of a binary DataFrame file. The last character is the format version.
+    constexpr char kBinaryMagic[8] = {'D', 'F', 'R', 'A', 'M', 'E', '\0', '2'};
+
+    //! \brief The data of each column in a binary DataFrame file starts at a multiple of this many bytes.
+    constexpr std::size_t kBinaryAlignment = 64;
+
+    template<typename T>
+    void WriteValue(std::ostream& out, const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    //! \brief Read a value from a binary DataFrame file and advance past it. Throws if [ptr, end) is too short.
+    template<typename T>
+    T ReadValue(const char*& ptr, const char* end) {
+        if (static_cast<std::size_t>(end - ptr) < sizeof(T)) {
+            throw std::exception();
+        }
+        T value;
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+}
+
 bool DataFrame::HasColumn(const std::string& name) {
     return GetColumn(name) != data_.end();
 }
@@ -57,6 +92,14 @@ bool DataFrame::Empty() const {
     return data_.empty();
 }
 
+Schema DataFrame::GetSchema() const {
+    Schema schema;
+    for (const auto& pr : data_) {
+        schema.emplace_back(pr.first, pr.second.GetDType());
+    }
+    return schema;
+}
+
 // ========================================
 //  Selection
 // ========================================
@@ -64,7 +107,8 @@ bool DataFrame::Empty() const {
 DataFrame::Column& DataFrame::operator[](const std::string& name) {
     auto it = GetColumn(name);
     if (it == data_.end()) {
-        data_.emplace_back(name, Column(DType::None, nullptr, NumRows()));
+        data_.emplace_back(name, Column(DType::None, IndexMap(), NumRows()));
+        column_index_.emplace(name, std::prev(data_.end()));
         return data_.back().second;
     }
     else {
@@ -77,68 +121,23 @@ DataFrame DataFrame::operator[](const Indicator& indicator) const {
         return DataFrame(); // Return an empty data frame upon failure.
     }
 
-    // Check if the indicator is all true (in which case we can just return a reference to this data frame)
-    // or all false (in which case we can return dataframes where all the index maps are non-null, but empty).
-    bool all_true = true, all_false = true;
-    for (bool ind : indicator) {
-        if (ind) {
-            all_false = false;
-        }
-        else {
-            all_true = false;
-        }
-        if (!all_true && !all_false) {
-            break;
-        }
-    }
-    if (all_true) {
-        return Ref(); // Return a data frame that references all that data in this data frame.
-    }
-    if (all_false) {
-        auto df = Ref();
-        for (auto& col_pair : df.data_) {
-            col_pair.second.index_map_ = MakeIndexMap();
-        }
+    // If the indicator is all true, we can just return a reference to this data frame.
+    if (indicator.All()) {
+        return Ref();
     }
 
     // Create a reference copy of this data frame.
     auto df = Ref();
 
-    // A map from old index maps (raw ptrs b/c shared ptrs might be different ) to new index maps.
-    std::map<std::vector<std::size_t>*, IMapType> new_index_maps;
-
-    // auto index_map = std::make_shared<std::vector<std::size_t>>();
-    for (const auto& col_pair : data_) {
-        auto& col = col_pair.second;
-        // Check if we already processed the index map that this column uses.
-        auto it = new_index_maps.find(col.index_map_.get());
-        if (it != new_index_maps.end()) {
-            continue;
-        }
-        // We have not processed this column's index map yet. Do so and save it.
-        auto new_index_map = MakeIndexMap();
-        if (col.index_map_ == nullptr) {
-            for (std::size_t i = 0; i < indicator.size(); ++i) {
-                if (indicator[i]) {
-                    new_index_map->push_back(i);
-                }
-            }
-        }
-        else {
-            for (std::size_t i = 0; i < indicator.size(); ++i) {
-                if (indicator[i]) {
-                    new_index_map->push_back((*col.index_map_)[i]);
-                }
-            }
-        }
-        // Add the new index map to the collection of new index maps.
-        new_index_maps.emplace(col.index_map_.get(), new_index_map);
-    }
-
-    // Update all the index maps in the columns of the new data frame.
+    // Columns that share an index map share the new index map too, so each index map only has to be selected from once.
+    // The encoding of each new index map is chosen by IndexMap::Select, based on what the indicator selects.
+    std::map<const void*, IndexMap> new_index_maps;
     for (auto& col_pair : df.data_) {
         auto& col = col_pair.second;
-        auto it = new_index_maps.find(col.index_map_.get());
+        auto it = new_index_maps.find(col.index_map_.Identity());
+        if (it == new_index_maps.end()) {
+            it = new_index_maps.emplace(col.index_map_.Identity(), col.index_map_.Select(indicator)).first;
+        }
         col.index_map_ = it->second; // Update the index map to be the new index map.
     }
 
@@ -154,7 +153,6 @@ DataFrame DataFrame::Clone() const {
     for (const auto& col : data_) {
         df[col.first] = col.second.Clone();
     }
-    // \TODO: Actual cloning part.
     return df;
 }
 
@@ -179,15 +177,15 @@ void DataFrame::Append(const DataFrame& df) {
     for (const auto& col : data_) {
         auto& name = col.first;
         auto it = df.GetColumn(name);
+        if (it == df.data_.end()) {
+            std::cout << "Did not find column " << col.first << " in DF.\n";
+            return; // TODO: Error handling.
+        }
         if (!col.second.SameTypeAs(it->second)) {
             std::cout << "Types do not match for column " << col.first << ". DTypes are " \
                 << col.second.GetDType() << " and " << it->second.GetDType() << "\n";
             return; // TODO: Error handling.
         }
-        if (it == df.data_.end()) {
-            std::cout << "Did not find column " << col.first << " in DF.\n";
-            return; // TODO: Error handling.
-        }
         iters.push_back(it);
     }
     // If we make it here, all columns matched.
@@ -205,6 +203,12 @@ void DataFrame::Append(const DataFrame& df) {
     }
 }
 
+void DataFrame::Compact() {
+    for (auto& col : data_) {
+        col.second.Compact();
+    }
+}
+
 // ========================================
 //  Rearranging, renaming, etc.
 // ========================================
@@ -215,7 +219,9 @@ bool DataFrame::Rename(const std::string& initial, const std::string& final) {
     }
     auto it = GetColumn(initial);
     if (it != data_.end()) {
+        UnindexColumn(it);
         it->first = final;
+        column_index_.emplace(final, it);
         return true;
     }
     return false;
@@ -234,6 +240,7 @@ std::size_t DataFrame::Rename(const std::map<std::string, std::string>& renaming
 bool DataFrame::DropColumn(const std::string& name) {
     auto it = GetColumn(name);
     if (it != data_.end()) {
+        UnindexColumn(it);
         data_.erase(it);
         return true;
     }
@@ -241,35 +248,38 @@ bool DataFrame::DropColumn(const std::string& name) {
 }
 
 std::size_t DataFrame::DropEmpty() {
-    std::size_t count_drops = 0;
-    for (auto it = data_.begin(); it != data_.end();) {
-        if (it->second.GetDType() == DType::Empty) {
-            auto jt = it;
-            ++it;
-            data_.erase(jt);
-            ++count_drops;
-        }
-        else {
-            ++it;
-        }
-    }
-    return count_drops;
+    // Unlink the nodes of the dropped columns, rather than assigning columns over each other, which would write into
+    // the columns that references to this frame share.
+    auto initial_size = data_.size();
+    data_.remove_if([](const auto& pr) { return pr.second.GetDType() == DType::Empty; });
+    IndexColumns();
+    return initial_size - data_.size();
 }
 
 std::size_t DataFrame::DropNones() {
-    std::size_t count_drops = 0;
-    for (auto it = data_.begin(); it != data_.end();) {
-        if (it->second.GetDType() == DType::None) {
-            auto jt = it;
-            ++it;
-            data_.erase(jt);
-            ++count_drops;
-        }
-        else {
-            ++it;
+    auto initial_size = data_.size();
+    data_.remove_if([](const auto& pr) { return pr.second.GetDType() == DType::None; });
+    IndexColumns();
+    return initial_size - data_.size();
+}
+
+// ========================================
+//  Statistics.
+// ========================================
+
+DataFrame DataFrame::Describe() const {
+    DataFrame description;
+    description["statistic"] = std::vector<std::string>{"count", "mean", "std", "min", "max", "sum"};
+    for (const auto& [name, column] : data_) {
+        auto dtype = column.GetDType();
+        if (!IsIntegerDType(dtype) && dtype != DType::Float && dtype != DType::Double) {
+            continue;
         }
+        auto statistics = column.Describe();
+        description[name] = std::vector<double>{static_cast<double>(statistics.count), statistics.mean,
+                                                 statistics.Std(), statistics.min, statistics.max, statistics.sum};
     }
-    return count_drops;
+    return description;
 }
 
 // ========================================
@@ -277,155 +287,344 @@ std::size_t DataFrame::DropNones() {
 // ========================================
 
 DataFrame DataFrame::FromStream(std::istream& in) {
-    // First, look for columns.
-    int numUnnamedColumns = 0;
+    return FromStream(in, CSVOptions());
+}
 
-    std::vector<std::string> colNames;
+DataFrame DataFrame::FromStream(std::istream& in, const CSVOptions& options) {
+    // First, look for columns.
+    CSVTokenizer tokenizer(options.delimiter, options.quote);
     std::string data;
-    {
-        getline(in, data);
-        std::istringstream stream(data);
-        while (getline(stream, data, ',')) {
-            data = TrimWhiteSpaceToFit(data);
-            if (data.empty()) {
-                colNames.push_back("Unnamed:" + std::to_string(numUnnamedColumns));
-                ++numUnnamedColumns;
-            }
-            else {
-                colNames.push_back(data);
-            }
-        }
+    tokenizer.ReadRow(in, data);
+    auto colNames = ReadColumnNames(data, options);
+
+    // Anything other than reading every column of every row with inferred dtypes uses the same in-memory parser
+    // as parsing in parallel.
+    if (options.num_threads != 1 || options.sample_dtypes || !options.dtypes.empty() || !options.schema.empty()
+        || !options.use_columns.empty() || !options.row_filters.empty() || !options.timestamp_formats.empty()) {
+        // Read the rest of the stream into memory, so it can be split up into chunks.
+        std::string buffer{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+        auto internal = ParseChunked(buffer.data(), buffer.data() + buffer.size(), colNames, options);
+        NarrowIntegers(internal, options);
+        DetectCategoricals(internal, options);
+        return DataFrame(std::move(internal));
     }
 
     // Set up the column storage.
-    StorageType internal;
-    for (const auto& name : colNames) {
-        internal.emplace_back(name, Column(DType::None));
+    StorageType internal = MakeStorage(colNames);
+    std::vector<Column*> columns;
+    for (auto& col_pair : internal) {
+        columns.push_back(&col_pair.second);
     }
     // Record the assumed dtype of every column. This will be updated as necessary.
     std::vector<DType> dtype_record(colNames.size(), DType::None);
 
-    // Get lines as long as possible.
-    int numRows = 0;
-    while (getline(in, data)) {
-        std::istringstream stream(data);
-
-        auto it = internal.begin();
-        auto dt = dtype_record.begin();
-        while (getline( stream, data, ',' )) {
-            // Trim whitespaces
-            data = TrimWhiteSpaceToFit(data);
-            // If the row has no type yet, or has been empty so far.
-            if (*dt == DType::None || *dt == DType::Empty) {
-                auto dtype = CheckDType(data);
-                if (dtype != DType::Empty) {
-                    // \TODO: Need to check if dtype can support NaNs, if there have been any.
-                    if (!it->second.box_->ConvertDType(dtype)) {
-                        throw std::exception();
-                    }
-                    it->second.box_->wrapper_->AddByString(data);
-                }
-                *dt = dtype;
-            }
-            else {
-                if (!RecheckDType(data, *dt)) {
-                    // Change type if possible.
-                    auto dtype = CheckDType(data);
-                    if (!it->second.box_->ConvertDType(dtype)) {
-                        throw std::exception();
-                    }
-                    *dt = dtype;
-                }
-                it->second.box_->wrapper_->AddByString(data);
-            }
-            ++it, ++dt;
-        }
-        ++numRows;
+    // Get rows as long as possible.
+    while (tokenizer.ReadRow(in, data)) {
+        tokenizer.ForEachField(data.data(), data.data() + data.size(), columns.size(),
+                               [&](std::size_t index, std::string_view field) {
+                                   AddField(*columns[index], dtype_record[index], field);
+                               });
     }
+    ReleaseSourceText(internal);
 
+    NarrowIntegers(internal, options);
+    DetectCategoricals(internal, options);
     return DataFrame(std::move(internal));
 }
 
 DataFrame DataFrame::ReadCSV(const std::string& filename) {
+    return ReadCSV(filename, CSVOptions());
+}
+
+DataFrame DataFrame::ReadCSV(const std::string& filename, const CSVOptions& options) {
+    if (options.memory_map) {
+        MemoryMappedFile file(filename);
+        if (!file.IsOpen()) {
+            return DataFrame();
+        }
+        const char *begin = file.Data(), *end = file.Data() + file.Size();
+        auto header_end = CSVTokenizer(options.delimiter, options.quote).FindRowEnd(begin, end);
+        auto colNames = ReadColumnNames(std::string(begin, header_end), options);
+        begin = header_end == end ? end : header_end + 1;
+        auto internal = ParseChunked(begin, end, colNames, options);
+        NarrowIntegers(internal, options);
+        DetectCategoricals(internal, options);
+        return DataFrame(std::move(internal));
+    }
+
     std::ifstream fin(filename);
     if (fin.fail()) {
         return DataFrame();
     }
-    auto df = FromStream(fin);
+    auto df = FromStream(fin, options);
     fin.close();
     return df;
 }
 
+Schema DataFrame::InferSchema(const std::string& filename, const CSVOptions& options) {
+    MemoryMappedFile file(filename);
+    if (!file.IsOpen()) {
+        return {};
+    }
+    const char *begin = file.Data(), *end = file.Data() + file.Size();
+    auto header_end = CSVTokenizer(options.delimiter, options.quote).FindRowEnd(begin, end);
+    auto colNames = ReadColumnNames(std::string(begin, header_end), options);
+    begin = header_end == end ? end : header_end + 1;
+
+    auto dtypes = SampleDTypes(begin, end, colNames.size(), options);
+    Schema schema;
+    for (std::size_t i = 0; i < colNames.size(); ++i) {
+        schema.emplace_back(colNames[i], dtypes[i]);
+    }
+    return schema;
+}
+
 bool DataFrame::ToStream(std::ostream& out) {
-    std::size_t i = 0;
+    return ToStream(out, CSVOptions());
+}
+
+bool DataFrame::ToStream(std::ostream& out, const CSVOptions& options) {
     // Print column names.
+    std::string buffer;
+    std::size_t i = 0;
     for (const auto& pr : data_) {
-        out << pr.first;
-        if (i != NumCols() - 1) {
-            out << ",";
+        if (i != 0) {
+            buffer += options.delimiter;
         }
+        TextFormat<std::string>::Append(pr.first, buffer, options.delimiter, options.quote);
         ++i;
     }
-    out << "\n";
-    // Print data.
-    for (std::size_t it = 0; it < NumRows(); ++it) {
-        i = 0;
-        for (const auto& pr : data_) {
-            pr.second.ToStream(it, out);
-            if (i != NumCols() - 1) {
-                out << ",";
-            }
-            ++i;
+    buffer += '\n';
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    // Print data, a block of rows at a time.
+    const std::size_t num_rows = NumRows(), block_rows = std::max<std::size_t>(1, options.write_block_rows);
+    std::size_t num_threads = options.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::max<std::size_t>(1, std::min(num_threads, (num_rows + block_rows - 1) / block_rows));
+
+    if (num_threads == 1) {
+        for (std::size_t first = 0; first < num_rows; first += block_rows) {
+            FormatRows(first, std::min(num_rows, first + block_rows), options, buffer);
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
         }
-        out << "\n";
+        return !out.fail();
     }
 
-    return true;
+    // Format num_threads blocks at a time, one per thread, then write them in order.
+    std::vector<std::string> buffers(num_threads);
+    for (std::size_t first = 0; first < num_rows; first += num_threads * block_rows) {
+        std::vector<std::future<void>> workers;
+        for (std::size_t t = 0; t < num_threads && first + t * block_rows < num_rows; ++t) {
+            auto begin = first + t * block_rows;
+            workers.push_back(std::async(std::launch::async, [&, t, begin] {
+                FormatRows(begin, std::min(num_rows, begin + block_rows), options, buffers[t]);
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.wait();
+        }
+        for (std::size_t t = 0; t < workers.size(); ++t) {
+            workers[t].get();
+            out.write(buffers[t].data(), static_cast<std::streamsize>(buffers[t].size()));
+        }
+    }
+    return !out.fail();
 }
 
 bool DataFrame::ToCSV(const std::string& filename) {
+    return ToCSV(filename, CSVOptions());
+}
+
+bool DataFrame::ToCSV(const std::string& filename, const CSVOptions& options) {
     std::ofstream fout(filename);
     if (fout.fail()) {
         return false;
     }
-    bool status = ToStream(fout);
+    bool status = ToStream(fout, options);
     fout.close();
     return status;
 }
 
+bool DataFrame::Save(const std::string& filename) const {
+    for (const auto& pr : data_) {
+        if (pr.second.GetDType() == DType::Other) {
+            return false;
+        }
+    }
+    std::ofstream fout(filename, std::ios::binary);
+    if (fout.fail()) {
+        return false;
+    }
+
+    // The data and validity bitmap of every column, each aligned, followed by a directory of the columns. Columns
+    // without nulls have an empty validity section.
+    const std::size_t num_rows = NumRows();
+    const char padding[kBinaryAlignment] = {};
+    auto align = [&] () {
+        auto position = static_cast<std::uint64_t>(fout.tellp());
+        auto padding_size = (kBinaryAlignment - position % kBinaryAlignment) % kBinaryAlignment;
+        fout.write(padding, static_cast<std::streamsize>(padding_size));
+        return position + padding_size;
+    };
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> sections, validity_sections;
+    fout.write(kBinaryMagic, sizeof(kBinaryMagic));
+    for (const auto& pr : data_) {
+        const auto& column = pr.second;
+        auto position = align();
+        if (!column.box_->wrapper_->WriteBinary(fout, column.index_map_, num_rows)) {
+            return false;
+        }
+        sections.emplace_back(position, static_cast<std::uint64_t>(fout.tellp()) - position);
+
+        position = align();
+        const auto& validity = column.box_->wrapper_->validity;
+        if (!validity.AllValid()) {
+            auto gathered = column.index_map_.IsFull() ? ValidityBitmap() : validity.Gather(column.index_map_);
+            const auto& words = column.index_map_.IsFull() ? validity.Words() : gathered.Words();
+            fout.write(reinterpret_cast<const char*>(words.data()),
+                       static_cast<std::streamsize>(words.size() * sizeof(std::uint64_t)));
+        }
+        validity_sections.emplace_back(position, static_cast<std::uint64_t>(fout.tellp()) - position);
+    }
+
+    auto directory = static_cast<std::uint64_t>(fout.tellp());
+    WriteValue<std::uint64_t>(fout, num_rows);
+    WriteValue<std::uint64_t>(fout, data_.size());
+    std::size_t i = 0;
+    for (const auto& pr : data_) {
+        WriteValue<std::uint64_t>(fout, pr.first.size());
+        fout.write(pr.first.data(), static_cast<std::streamsize>(pr.first.size()));
+        WriteValue<std::int32_t>(fout, static_cast<std::int32_t>(pr.second.GetDType()));
+        WriteValue<std::uint64_t>(fout, sections[i].first);
+        WriteValue<std::uint64_t>(fout, sections[i].second);
+        WriteValue<std::uint64_t>(fout, validity_sections[i].first);
+        WriteValue<std::uint64_t>(fout, validity_sections[i].second);
+        ++i;
+    }
+    WriteValue<std::uint64_t>(fout, directory);
+    fout.write(kBinaryMagic, sizeof(kBinaryMagic));
+    fout.close();
+    return !fout.fail();
+}
+
+DataFrame DataFrame::Load(const std::string& filename) {
+    // The columns keep the mapping alive, since the data of fixed width columns is used in place.
+    auto mapping = std::make_shared<const MemoryMappedFile>(filename);
+    const auto& file = *mapping;
+    if (!file.IsOpen()) {
+        return DataFrame();
+    }
+    const char *begin = file.Data(), *end = file.Data() + file.Size();
+    const std::size_t trailer_size = sizeof(std::uint64_t) + sizeof(kBinaryMagic);
+    if (file.Size() < sizeof(kBinaryMagic) + trailer_size
+        || std::memcmp(begin, kBinaryMagic, sizeof(kBinaryMagic)) != 0
+        || std::memcmp(end - sizeof(kBinaryMagic), kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+        throw std::exception();
+    }
+
+    // Find the directory of the columns.
+    const char* directory_end = end - trailer_size;
+    auto ptr = directory_end;
+    auto directory = ReadValue<std::uint64_t>(ptr, end);
+    if (directory < sizeof(kBinaryMagic) || directory > static_cast<std::uint64_t>(directory_end - begin)) {
+        throw std::exception();
+    }
+    ptr = begin + directory;
+    auto num_rows = ReadValue<std::uint64_t>(ptr, directory_end);
+    auto num_columns = ReadValue<std::uint64_t>(ptr, directory_end);
+    // Every column stores at least a bit per row, in its data or its validity bitmap, so a file cannot hold more rows
+    // than it has bits. Checking this before reading any column keeps a corrupt num_rows from overflowing the sizes
+    // computed from it, or making the columns allocate more than the file could fill.
+    if (num_rows / 8 > file.Size()) {
+        throw std::exception();
+    }
+
+    StorageType internal;
+    for (std::uint64_t i = 0; i < num_columns; ++i) {
+        auto name_size = ReadValue<std::uint64_t>(ptr, directory_end);
+        if (static_cast<std::uint64_t>(directory_end - ptr) < name_size) {
+            throw std::exception();
+        }
+        std::string name(ptr, name_size);
+        ptr += name_size;
+        auto dtype = static_cast<DType>(ReadValue<std::int32_t>(ptr, directory_end));
+        auto offset = ReadValue<std::uint64_t>(ptr, directory_end);
+        auto size = ReadValue<std::uint64_t>(ptr, directory_end);
+        auto validity_offset = ReadValue<std::uint64_t>(ptr, directory_end);
+        auto validity_size = ReadValue<std::uint64_t>(ptr, directory_end);
+        if (offset > directory || size > directory - offset
+            || validity_offset > directory || validity_size > directory - validity_offset
+            || (validity_size != 0 && validity_size != ValidityBitmap::WordsFor(num_rows) * sizeof(std::uint64_t))) {
+            throw std::exception();
+        }
+
+        // Throws if the dtype is not valid.
+        Column column(dtype);
+        auto& wrapper = column.box_->wrapper_;
+        if (!wrapper->ReadBinary(begin + offset, size, num_rows, mapping)) {
+            throw std::exception();
+        }
+        if (validity_size != 0) {
+            wrapper->validity.Assign(begin + validity_offset, num_rows);
+        }
+        internal.emplace_back(std::move(name), std::move(column));
+    }
+    return DataFrame(std::move(internal));
+}
+
 // ========================================
 //  Private helper functions.
 // ========================================
 
-DataFrame::IMapType DataFrame::MakeIndexMap() {
-    return std::make_shared<std::vector<std::size_t>>();
-}
-
 void DataFrame::AddEntriesToIndexMap(std::size_t num_entries) {
-    std::map<std::vector<std::size_t>*, std::size_t> index_maps;
+    // Full index maps already include the new entries.
+    std::map<const void*, std::pair<IndexMap, std::size_t>> index_maps;
     for (const auto& col_pair : data_) {
         auto& col = col_pair.second;
-        if (index_maps.find(col.index_map_.get()) == index_maps.end()) {
-            index_maps.emplace(col.index_map_.get(), col.FullSize());
+        if (!col.index_map_.IsFull() && index_maps.find(col.index_map_.Identity()) == index_maps.end()) {
+            index_maps.emplace(col.index_map_.Identity(), std::make_pair(col.index_map_, col.FullSize()));
         }
     }
-    for (const auto pr : index_maps) {
-        if (pr.first) {
-            for (std::size_t i = 0; i < num_entries; ++i) {
-                pr.first->push_back(pr.second + i);
-            }
+    for (auto& pr : index_maps) {
+        for (std::size_t i = 0; i < num_entries; ++i) {
+            pr.second.first.PushBack(pr.second.second + i);
+        }
+    }
+}
+
+void DataFrame::IndexColumns() {
+    column_index_.clear();
+    column_index_.reserve(data_.size());
+    for (auto it = data_.begin(); it != data_.end(); ++it) {
+        column_index_.emplace(it->first, it);
+    }
+}
+
+void DataFrame::UnindexColumn(StorageType::iterator it) {
+    // Only a frame with fewer names than columns can have another column with this name, and it must come later in
+    // data_, since the index holds the first column with each name.
+    bool has_duplicates = column_index_.size() < data_.size();
+    column_index_.erase(it->first);
+    if (has_duplicates) {
+        auto duplicate = std::find_if(std::next(it), data_.end(),
+                                      [&](const auto& pr) { return pr.first == it->first; });
+        if (duplicate != data_.end()) {
+            column_index_.emplace(it->first, duplicate);
         }
     }
 }
 
 DataFrame::StorageType::iterator DataFrame::GetColumn(const std::string& name) {
-    return std::find_if(data_.begin(), data_.end(),
-                        [&](const auto& pr) { return pr.first == name; });
+    auto it = column_index_.find(name);
+    return it == column_index_.end() ? data_.end() : it->second;
 }
 
 DataFrame::StorageType::const_iterator DataFrame::GetColumn(const std::string& name) const {
-    return std::find_if(data_.cbegin(), data_.cend(),
-                        [&](const auto& pr) { return pr.first == name; });
+    auto it = column_index_.find(name);
+    return it == column_index_.end() ? data_.cend() : StorageType::const_iterator(it->second);
 }
 
 std::string DataFrame::TrimWhiteSpaceToFit(const std::string& name) {
@@ -444,4 +643,421 @@ std::string DataFrame::TrimWhiteSpaceToFit(const std::string& name) {
     }
 
     return output;
-}
\ No newline at end of file
+}
+
+std::vector<std::string> DataFrame::ReadColumnNames(const std::string& header, const CSVOptions& options) {
+    int numUnnamedColumns = 0;
+
+    std::vector<std::string> colNames;
+    CSVTokenizer tokenizer(options.delimiter, options.quote);
+    tokenizer.ForEachField(header.data(), header.data() + header.size(), header.size() + 1,
+                           [&](std::size_t, std::string_view name) {
+                               if (name.empty()) {
+                                   colNames.push_back("Unnamed:" + std::to_string(numUnnamedColumns));
+                                   ++numUnnamedColumns;
+                               }
+                               else {
+                                   colNames.emplace_back(name);
+                               }
+                           });
+    return colNames;
+}
+
+DataFrame::StorageType DataFrame::MakeStorage(const std::vector<std::string>& names) {
+    return MakeStorage(names, std::vector<DType>(names.size(), DType::None));
+}
+
+DataFrame::StorageType DataFrame::MakeStorage(const std::vector<std::string>& names, const std::vector<DType>& dtypes) {
+    StorageType internal;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        internal.emplace_back(names[i], Column(dtypes[i]));
+    }
+    return internal;
+}
+
+bool DataFrame::RecycleStorage(StorageType& storage, const std::vector<std::string>& names,
+                               const std::vector<DType>& dtypes) {
+    if (storage.size() != names.size()) {
+        return false;
+    }
+    std::size_t i = 0;
+    for (const auto& col_pair : storage) {
+        auto& column = col_pair.second;
+        // The data can only be reused if no other column, Concrete, or DataFrame can see it.
+        if (col_pair.first != names[i] || column.GetDType() != dtypes[i] || !column.index_map_.IsFull()
+            || column.box_.use_count() != 1 || column.box_->wrapper_.use_count() != 1) {
+            return false;
+        }
+        ++i;
+    }
+    for (auto& col_pair : storage) {
+        col_pair.second.box_->wrapper_->Clear();
+    }
+    return true;
+}
+
+std::vector<DType> DataFrame::SampleDTypes(const char* begin, const char* end, std::size_t num_columns,
+                                           const CSVOptions& options) {
+    std::vector<DType> dtypes(num_columns, DType::None);
+    CSVTokenizer tokenizer(options.delimiter, options.quote);
+    auto sample = [&](const char* ptr, std::size_t num_rows) {
+        for (std::size_t row = 0; row < num_rows && ptr < end; ++row) {
+            ptr = tokenizer.ForEachField(ptr, end, num_columns, [&](std::size_t index, std::string_view field) {
+                auto dtype = CheckDType(field);
+                // Empty fields do not say anything about the dtype of a column.
+                if (dtype != DType::Empty) {
+                    auto common = CommonDType(dtypes[index], dtype);
+                    // If the sampled values have no common dtype, only a string can hold them all.
+                    dtypes[index] = common == DType::Other ? DType::String : common;
+                }
+            });
+        }
+    };
+
+    // Sample the head of the data, then short runs of rows spaced evenly through the rest of the data.
+    sample(begin, options.sample_head_rows);
+    std::size_t size = end - begin;
+    auto row_start = begin;
+    for (std::size_t i = 1; i <= options.sample_strides; ++i) {
+        auto target = std::max(row_start, begin + i * (size / (options.sample_strides + 1)));
+        row_start = tokenizer.FindRowStart(row_start, target, end);
+        sample(row_start, options.sample_stride_rows);
+    }
+    return dtypes;
+}
+
+void DataFrame::AddField(Column& column, DType& dtype, std::string_view data) {
+    // Classify and convert the field in one pass.
+    auto field = ParseField(data);
+    // If the row has no type yet, or has been empty so far. Any empty fields so far become nulls of the new type.
+    if (dtype == DType::None || dtype == DType::Empty) {
+        if (!column.box_->ConvertDType(field.dtype)) {
+            throw std::exception();
+        }
+        column.box_->wrapper_->AddInferred(field, data);
+        dtype = field.dtype;
+    }
+    else {
+        if (!RecheckDType(field.dtype, dtype)) {
+            // Change to a type that can hold both the column and the field, if there is one.
+            auto common = CommonDType(dtype, field.dtype);
+            if (common == DType::Other || !column.box_->ConvertDType(common)) {
+                throw std::exception();
+            }
+            dtype = common;
+        }
+        column.box_->wrapper_->AddInferred(field, data);
+    }
+}
+
+DataFrame::StorageType DataFrame::ParseChunked(const char* begin, const char* end,
+                                               std::vector<std::string> names, const CSVOptions& options) {
+    // A full schema replaces the names from the header.
+    ApplySchemaNames(names, options);
+
+    std::size_t num_threads = options.num_threads;
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::size_t size = end - begin;
+    num_threads = std::max<std::size_t>(1, std::min(num_threads, size / std::max<std::size_t>(1, options.min_chunk_size)));
+
+    // Find the boundaries of the chunks. Every chunk (except possibly the last) ends just after a newline that is
+    // not inside of a quoted field.
+    CSVTokenizer tokenizer(options.delimiter, options.quote);
+    std::vector<const char*> boundaries{begin};
+    for (std::size_t i = 1; i < num_threads; ++i) {
+        auto target = std::max(boundaries.back(), begin + i * (size / num_threads));
+        boundaries.push_back(tokenizer.FindRowStart(boundaries.back(), target, end));
+    }
+    boundaries.push_back(end);
+
+    // If requested, decide the dtypes of the columns up front, so columns do not have to be converted as they are
+    // read. Columns that were not decided start out as DType::None, and are inferred as they are read.
+    auto field_dtypes = options.sample_dtypes ? SampleDTypes(begin, end, names.size(), options)
+                                              : std::vector<DType>(names.size(), DType::None);
+
+    // Decide which fields of each row are stored, and in which columns.
+    std::vector<std::string> column_names;
+    std::vector<DType> dtypes;
+    auto plan = MakePlan(names, field_dtypes, options, column_names, dtypes);
+
+    std::vector<StorageType> chunks;
+    std::vector<std::vector<DType>> chunk_dtypes;
+    for (std::size_t i = 0; i + 1 < boundaries.size(); ++i) {
+        chunks.push_back(MakeStorage(column_names, dtypes));
+        chunk_dtypes.push_back(dtypes);
+    }
+    if (chunks.size() == 1) {
+        ParseRows(begin, end, chunks[0], chunk_dtypes[0], plan);
+        ReleaseSourceText(chunks[0]);
+        return std::move(chunks[0]);
+    }
+
+    // Parse every chunk on its own thread.
+    std::vector<std::future<void>> workers;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        workers.push_back(std::async(std::launch::async, [&, i] {
+            ParseRows(boundaries[i], boundaries[i + 1], chunks[i], chunk_dtypes[i], plan);
+        }));
+    }
+    // Wait for all the workers before rethrowing any exception, since they reference the chunks.
+    for (auto& worker : workers) {
+        worker.wait();
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+
+    // Splice the chunks together, in order.
+    StorageType internal = std::move(chunks[0]);
+    for (std::size_t i = 1; i < chunks.size(); ++i) {
+        MergeChunk(internal, chunks[i]);
+    }
+    // Freshly read columns are stored contiguously.
+    for (auto& pr : internal) {
+        pr.second.Compact();
+    }
+    ReleaseSourceText(internal);
+    return internal;
+}
+
+void DataFrame::ApplySchemaNames(std::vector<std::string>& names, const CSVOptions& options) {
+    if (!options.schema.empty()) {
+        if (options.schema.size() != names.size()) {
+            throw std::exception();
+        }
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            names[i] = options.schema[i].first;
+        }
+    }
+}
+
+DataFrame::ParsePlan DataFrame::MakePlan(const std::vector<std::string>& names, const std::vector<DType>& field_dtypes,
+                                         const CSVOptions& options, std::vector<std::string>& column_names,
+                                         std::vector<DType>& dtypes) {
+    // Reading a column that is not in the csv is an error, like filtering on one.
+    for (const auto& name : options.use_columns) {
+        if (std::find(names.begin(), names.end(), name) == names.end()) {
+            throw std::exception();
+        }
+    }
+
+    ParsePlan plan;
+    plan.delimiter = options.delimiter;
+    plan.quote = options.quote;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        if (!options.use_columns.empty()
+            && std::find(options.use_columns.begin(), options.use_columns.end(), names[i]) == options.use_columns.end()) {
+            plan.columns.push_back(-1);
+            continue;
+        }
+        plan.columns.push_back(static_cast<long>(column_names.size()));
+        plan.num_fields = i + 1;
+        column_names.push_back(names[i]);
+
+        // Columns whose dtypes were given are parsed directly into their dtypes, without any inference.
+        auto it = options.dtypes.find(names[i]);
+        auto dtype = options.schema.empty() ? DType::None : options.schema[i].second;
+        if (it != options.dtypes.end()) {
+            dtype = it->second;
+        }
+        // Columns with timestamp formats are timestamp columns, read with their formats.
+        auto jt = options.timestamp_formats.find(names[i]);
+        if (jt != options.timestamp_formats.end()) {
+            dtype = DType::Timestamp;
+            plan.timestamp_formats.emplace_back(jt->second);
+        }
+        else {
+            plan.timestamp_formats.emplace_back();
+        }
+        plan.fixed.push_back(dtype != DType::None);
+        dtypes.push_back(dtype != DType::None ? dtype : field_dtypes[i]);
+    }
+    for (const auto& filter : options.row_filters) {
+        auto it = std::find(names.begin(), names.end(), filter.column);
+        if (it == names.end()) {
+            throw std::exception();
+        }
+        auto index = static_cast<std::size_t>(it - names.begin());
+        plan.filters.emplace_back(index, &filter);
+        plan.num_fields = std::max(plan.num_fields, index + 1);
+    }
+
+    return plan;
+}
+
+void DataFrame::ParseRows(const char* begin, const char* end, StorageType& storage, std::vector<DType>& dtypes,
+                          const ParsePlan& plan) {
+    // Columns whose dtypes are already known can be sized for all the rows up front.
+    auto num_rows = static_cast<std::size_t>(std::count(begin, end, '\n')) + 1;
+    std::vector<Column*> columns;
+    for (auto& col_pair : storage) {
+        columns.push_back(&col_pair.second);
+        if (dtypes[columns.size() - 1] != DType::None) {
+            col_pair.second.box_->wrapper_->Reserve(num_rows);
+        }
+    }
+
+    CSVTokenizer tokenizer(plan.delimiter, plan.quote);
+    std::vector<std::string_view> fields(plan.num_fields);
+    while (begin < end) {
+        // Split the row into fields. Nothing is parsed yet.
+        std::size_t num_fields = 0;
+        begin = tokenizer.ForEachField(begin, end, plan.num_fields, [&](std::size_t index, std::string_view field) {
+            fields[index] = field;
+            num_fields = index + 1;
+        });
+
+        // Check whether the row passes the filters before anything is parsed or stored.
+        bool keep = true;
+        for (const auto& filter : plan.filters) {
+            if (num_fields <= filter.first || !filter.second->keep(fields[filter.first])) {
+                keep = false;
+                break;
+            }
+        }
+        if (!keep) {
+            continue;
+        }
+
+        for (std::size_t i = 0; i < num_fields; ++i) {
+            auto index = plan.columns[i];
+            if (index < 0) {
+                continue; // The field's column is not read.
+            }
+            if (plan.fixed[index] && !plan.timestamp_formats[index].Empty()) {
+                ParsedField field;
+                Timestamp timestamp;
+                if (plan.timestamp_formats[index].Parse(fields[i], timestamp)) {
+                    field.dtype = DType::Timestamp;
+                    field.integer = timestamp.seconds;
+                }
+                columns[index]->box_->wrapper_->AddParsed(field, fields[i]);
+            }
+            else if (plan.fixed[index]) {
+                columns[index]->box_->wrapper_->AddConverted(fields[i]);
+            }
+            else {
+                AddField(*columns[index], dtypes[index], fields[i]);
+            }
+        }
+    }
+}
+
+bool DataFrame::HasGivenDType(const std::string& name, const CSVOptions& options) {
+    return options.dtypes.find(name) != options.dtypes.end()
+           || options.timestamp_formats.find(name) != options.timestamp_formats.end()
+           || std::any_of(options.schema.begin(), options.schema.end(), [&](const auto& entry) {
+               return entry.first == name && entry.second != DType::None;
+           });
+}
+
+void DataFrame::NarrowIntegers(StorageType& storage, const CSVOptions& options) {
+    if (!options.narrow_integers) {
+        return;
+    }
+    for (auto& col_pair : storage) {
+        auto& column = col_pair.second;
+        auto dtype = column.GetDType();
+        if ((dtype != DType::Integer && dtype != DType::Int64) || HasGivenDType(col_pair.first, options)) {
+            continue;
+        }
+        // Find the range of the values. Nulls do not count.
+        long long min = 0, max = 0;
+        bool first = true;
+        auto find_range = [&](const auto& concrete) {
+            for (std::size_t i = 0; i < concrete.Size(); ++i) {
+                if (column.IsNull(i)) {
+                    continue;
+                }
+                auto value = static_cast<long long>(concrete[i]);
+                min = first || value < min ? value : min;
+                max = first || max < value ? value : max;
+                first = false;
+            }
+        };
+        if (dtype == DType::Integer) {
+            find_range(column.ReadConcrete<int>());
+        }
+        else {
+            find_range(column.ReadConcrete<std::int64_t>());
+        }
+        auto narrowest = NarrowestIntegerDType(min, max);
+        if (narrowest != dtype) {
+            column.box_->ConvertDType(narrowest);
+        }
+    }
+}
+
+void DataFrame::DetectCategoricals(StorageType& storage, const CSVOptions& options, const std::vector<bool>& fixed) {
+    if (options.categorical_fraction <= 0) {
+        return;
+    }
+    std::size_t index = 0;
+    for (auto& col_pair : storage) {
+        auto& column = col_pair.second;
+        bool is_fixed = (index < fixed.size() && fixed[index++]) || HasGivenDType(col_pair.first, options);
+        if (is_fixed || column.GetDType() != DType::String) {
+            continue;
+        }
+        auto max_categories = static_cast<std::size_t>(options.categorical_fraction * column.Size());
+        if (max_categories == 0) {
+            continue;
+        }
+        // Count the distinct values, stopping as soon as there are too many.
+        const auto concrete = column.ReadConcrete<std::string>();
+        std::unordered_set<std::string_view> distinct;
+        for (std::size_t i = 0; i < concrete.Size() && distinct.size() <= max_categories; ++i) {
+            distinct.insert(concrete[i]);
+        }
+        if (distinct.size() <= max_categories) {
+            column.box_->ConvertDType(DType::Categorical);
+        }
+    }
+}
+
+void DataFrame::FormatRows(std::size_t first, std::size_t last, const CSVOptions& options, std::string& buffer) const {
+    // Format a block of each column at a time, so there is one virtual call per column instead of one per entry.
+    std::vector<std::string> texts(data_.size());
+    std::vector<std::vector<std::size_t>> ends(data_.size());
+    std::size_t size = 0, c = 0;
+    for (const auto& col_pair : data_) {
+        const auto& column = col_pair.second;
+        column.box_->wrapper_->FormatRange(first, last, column.index_map_, options.delimiter, options.quote,
+                                           texts[c], ends[c]);
+        size += texts[c].size();
+        ++c;
+    }
+
+    // Interleave the columns' text into rows.
+    buffer.clear();
+    buffer.reserve(size + (last - first) * data_.size());
+    for (std::size_t row = 0; row < last - first; ++row) {
+        for (c = 0; c < data_.size(); ++c) {
+            auto start = row == 0 ? 0 : ends[c][row - 1];
+            buffer.append(texts[c], start, ends[c][row] - start);
+            buffer += c + 1 == data_.size() ? '\n' : options.delimiter;
+        }
+    }
+}
+
+void DataFrame::MergeChunk(StorageType& storage, StorageType& chunk) {
+    for (auto it = storage.begin(), jt = chunk.begin(); it != storage.end(); ++it, ++jt) {
+        auto& column = it->second;
+        auto& chunk_column = jt->second;
+        auto common = CommonDType(column.GetDType(), chunk_column.GetDType());
+        if (common == DType::Other
+            || !column.box_->ConvertDType(common)
+            || !chunk_column.box_->ConvertDType(common)
+            || !column.Append(chunk_column)) {
+            throw std::exception();
+        }
+    }
+}
+
+void DataFrame::ReleaseSourceText(StorageType& storage) {
+    for (auto& pr : storage) {
+        pr.second.box_->wrapper_->ReleaseSourceText();
+    }
+}
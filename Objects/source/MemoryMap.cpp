@@ -0,0 +1,66 @@
+//
+// Created by Nathaniel Rupprecht on 5/16/21.
+//
+
+#include "../include/MemoryMap.h"
+// Other files
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DATAFRAME_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace dataframe;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filename) {
+#ifdef DATAFRAME_HAS_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return;
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ == 0) { // Cannot map an empty file, but there is nothing to map anyways.
+        close(fd);
+        is_open_ = true;
+        return;
+    }
+    void* ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file descriptor is closed.
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        size_ = 0;
+        return;
+    }
+    // The file will be read front to back.
+    madvise(ptr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(ptr);
+    is_open_ = true;
+#else
+    std::ifstream fin(filename, std::ios::binary);
+    if (fin.fail()) {
+        return;
+    }
+    fallback_.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    is_open_ = true;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+#ifdef DATAFRAME_HAS_MMAP
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
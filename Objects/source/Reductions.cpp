@@ -0,0 +1,247 @@
+//
+// Created by Nathaniel Rupprecht on 6/12/21.
+//
+
+#include "../include/Reductions.h"
+// Other files
+#include "../include/CompareKernels.h"
+#include <algorithm>
+
+#if defined(__x86_64__)
+#define DATAFRAME_X86_SIMD
+#include <immintrin.h>
+//! \brief Compile a function for AVX2, whether or not the rest of the library is. It is only called if the processor
+//! has AVX2.
+#define DATAFRAME_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace dataframe;
+using namespace dataframe::kernels;
+
+namespace {
+
+    // ========================================
+    //  Plain loops.
+    // ========================================
+
+    void ScalarSumMinMax(const double *data, std::size_t first, std::size_t size, BlockSums &sums) {
+        for (std::size_t i = first; i < size; ++i) {
+            const auto x = data[i];
+            if (x == x) {
+                ++sums.count;
+                sums.sum += x;
+                sums.min = std::min(sums.min, x);
+                sums.max = std::max(sums.max, x);
+            }
+        }
+    }
+
+    double ScalarSumSquaredDeviations(const double *data, std::size_t first, std::size_t size, double mean) {
+        double sum = 0.;
+        for (std::size_t i = first; i < size; ++i) {
+            const auto d = data[i] - mean;
+            if (d == d) {
+                sum += d * d;
+            }
+        }
+        return sum;
+    }
+
+#ifdef DATAFRAME_X86_SIMD
+
+    // Lanes that hold NaN are masked out of the sums and counts by comparing each value with itself. The min and max
+    // instructions return their second operand if either operand is NaN, so NaNs never replace the running min or max.
+
+    // ========================================
+    //  SSE2.
+    // ========================================
+
+    BlockSums Sse2SumMinMax(const double *data, std::size_t size) {
+        const auto ones = _mm_set1_pd(1.);
+        auto sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd(), count = _mm_setzero_pd();
+        auto min = _mm_set1_pd(std::numeric_limits<double>::infinity()), max = _mm_sub_pd(_mm_setzero_pd(), min);
+        std::size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            auto x0 = _mm_loadu_pd(data + i), x1 = _mm_loadu_pd(data + i + 2);
+            auto m0 = _mm_cmpord_pd(x0, x0), m1 = _mm_cmpord_pd(x1, x1);
+            sum0 = _mm_add_pd(sum0, _mm_and_pd(x0, m0));
+            sum1 = _mm_add_pd(sum1, _mm_and_pd(x1, m1));
+            count = _mm_add_pd(count, _mm_add_pd(_mm_and_pd(m0, ones), _mm_and_pd(m1, ones)));
+            min = _mm_min_pd(x0, _mm_min_pd(x1, min));
+            max = _mm_max_pd(x0, _mm_max_pd(x1, max));
+        }
+        alignas(16) double s[2], c[2], lo[2], hi[2];
+        _mm_store_pd(s, _mm_add_pd(sum0, sum1));
+        _mm_store_pd(c, count);
+        _mm_store_pd(lo, min);
+        _mm_store_pd(hi, max);
+        BlockSums sums{static_cast<std::size_t>(c[0] + c[1]), s[0] + s[1], std::min(lo[0], lo[1]),
+                       std::max(hi[0], hi[1])};
+        ScalarSumMinMax(data, i, size, sums);
+        return sums;
+    }
+
+    double Sse2SumSquaredDeviations(const double *data, std::size_t size, double mean) {
+        const auto m = _mm_set1_pd(mean);
+        auto sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            auto d0 = _mm_sub_pd(_mm_loadu_pd(data + i), m), d1 = _mm_sub_pd(_mm_loadu_pd(data + i + 2), m);
+            d0 = _mm_and_pd(d0, _mm_cmpord_pd(d0, d0));
+            d1 = _mm_and_pd(d1, _mm_cmpord_pd(d1, d1));
+            sum0 = _mm_add_pd(sum0, _mm_mul_pd(d0, d0));
+            sum1 = _mm_add_pd(sum1, _mm_mul_pd(d1, d1));
+        }
+        alignas(16) double s[2];
+        _mm_store_pd(s, _mm_add_pd(sum0, sum1));
+        return s[0] + s[1] + ScalarSumSquaredDeviations(data, i, size, mean);
+    }
+
+    // ========================================
+    //  AVX2.
+    // ========================================
+
+    DATAFRAME_AVX2 BlockSums Avx2SumMinMax(const double *data, std::size_t size) {
+        const auto ones = _mm256_set1_pd(1.);
+        auto sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd(), count = _mm256_setzero_pd();
+        auto min = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        auto max = _mm256_sub_pd(_mm256_setzero_pd(), min);
+        std::size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            auto x0 = _mm256_loadu_pd(data + i), x1 = _mm256_loadu_pd(data + i + 4);
+            auto m0 = _mm256_cmp_pd(x0, x0, _CMP_ORD_Q), m1 = _mm256_cmp_pd(x1, x1, _CMP_ORD_Q);
+            sum0 = _mm256_add_pd(sum0, _mm256_and_pd(x0, m0));
+            sum1 = _mm256_add_pd(sum1, _mm256_and_pd(x1, m1));
+            count = _mm256_add_pd(count, _mm256_add_pd(_mm256_and_pd(m0, ones), _mm256_and_pd(m1, ones)));
+            min = _mm256_min_pd(x0, _mm256_min_pd(x1, min));
+            max = _mm256_max_pd(x0, _mm256_max_pd(x1, max));
+        }
+        alignas(32) double s[4], c[4], lo[4], hi[4];
+        _mm256_store_pd(s, _mm256_add_pd(sum0, sum1));
+        _mm256_store_pd(c, count);
+        _mm256_store_pd(lo, min);
+        _mm256_store_pd(hi, max);
+        BlockSums sums{static_cast<std::size_t>(c[0] + c[1] + c[2] + c[3]), (s[0] + s[1]) + (s[2] + s[3]),
+                       std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3])),
+                       std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]))};
+        ScalarSumMinMax(data, i, size, sums);
+        return sums;
+    }
+
+    DATAFRAME_AVX2 double Avx2SumSquaredDeviations(const double *data, std::size_t size, double mean) {
+        const auto m = _mm256_set1_pd(mean);
+        auto sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            auto d0 = _mm256_sub_pd(_mm256_loadu_pd(data + i), m);
+            auto d1 = _mm256_sub_pd(_mm256_loadu_pd(data + i + 4), m);
+            d0 = _mm256_and_pd(d0, _mm256_cmp_pd(d0, d0, _CMP_ORD_Q));
+            d1 = _mm256_and_pd(d1, _mm256_cmp_pd(d1, d1, _CMP_ORD_Q));
+            sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(d0, d0));
+            sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(d1, d1));
+        }
+        alignas(32) double s[4];
+        _mm256_store_pd(s, _mm256_add_pd(sum0, sum1));
+        return (s[0] + s[1]) + (s[2] + s[3]) + ScalarSumSquaredDeviations(data, i, size, mean);
+    }
+
+#endif // DATAFRAME_X86_SIMD
+}
+
+BlockSums kernels::SumMinMax(const double* data, std::size_t size) {
+#ifdef DATAFRAME_X86_SIMD
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            return Avx2SumMinMax(data, size);
+        case SimdLevel::SSE2:
+            return Sse2SumMinMax(data, size);
+        default:
+            break;
+    }
+#endif
+    BlockSums sums{0, 0., std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()};
+    ScalarSumMinMax(data, 0, size, sums);
+    return sums;
+}
+
+double kernels::SumSquaredDeviations(const double* data, std::size_t size, double mean) {
+#ifdef DATAFRAME_X86_SIMD
+    switch (GetSimdLevel()) {
+        case SimdLevel::AVX2:
+            return Avx2SumSquaredDeviations(data, size, mean);
+        case SimdLevel::SSE2:
+            return Sse2SumSquaredDeviations(data, size, mean);
+        default:
+            break;
+    }
+#endif
+    return ScalarSumSquaredDeviations(data, 0, size, mean);
+}
+
+// ========================================
+//  StatisticsAccumulator.
+// ========================================
+
+void StatisticsAccumulator::Add(const double* values, std::size_t size) {
+    const auto sums = kernels::SumMinMax(values, size);
+    if (sums.count == 0) {
+        return;
+    }
+    StatisticsAccumulator block(with_variance_);
+    block.count_ = sums.count;
+    block.sum_ = sums.sum;
+    block.mean_ = sums.sum / static_cast<double>(sums.count);
+    if (with_variance_) {
+        block.m2_ = kernels::SumSquaredDeviations(values, size, block.mean_);
+    }
+    block.min_ = sums.min;
+    block.max_ = sums.max;
+    Merge(block);
+}
+
+void StatisticsAccumulator::Merge(const StatisticsAccumulator& other) {
+    integer_sum_ += other.integer_sum_;
+    has_integer_sum_ = has_integer_sum_ || other.has_integer_sum_;
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        const auto integer_sum = integer_sum_;
+        const auto has_integer_sum = has_integer_sum_;
+        *this = other;
+        integer_sum_ = integer_sum;
+        has_integer_sum_ = has_integer_sum;
+        return;
+    }
+    const auto n = static_cast<double>(count_ + other.count_);
+    const auto n_a = static_cast<double>(count_), n_b = static_cast<double>(other.count_);
+    const auto delta = other.mean_ - mean_;
+    mean_ += delta * (n_b / n);
+    m2_ += other.m2_ + delta * delta * (n_a * n_b / n);
+
+    // Neumaier's variant of Kahan summation.
+    const auto total = sum_ + other.sum_;
+    compensation_ += std::abs(sum_) >= std::abs(other.sum_) ? (sum_ - total) + other.sum_
+                                                            : (other.sum_ - total) + sum_;
+    compensation_ += other.compensation_;
+    sum_ = total;
+
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+Statistics StatisticsAccumulator::Result() const {
+    Statistics statistics;
+    statistics.count = count_;
+    statistics.sum = has_integer_sum_ ? static_cast<double>(integer_sum_) : sum_ + compensation_;
+    if (count_ > 0) {
+        statistics.mean = statistics.sum / static_cast<double>(count_);
+        statistics.min = min_;
+        statistics.max = max_;
+    }
+    if (count_ > 1 && with_variance_) {
+        statistics.variance = m2_ / static_cast<double>(count_ - 1);
+    }
+    return statistics;
+}